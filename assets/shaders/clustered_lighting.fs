@@ -0,0 +1,88 @@
+#version 330
+
+in vec3 fragPosition;
+in vec2 fragTexCoord;
+in vec3 fragNormal;
+
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec3 viewPos;
+
+// Light structures
+#define MAX_LIGHTS 4
+struct Light {
+    int enabled;
+    int type;
+    vec3 position;
+    vec3 target;
+    vec4 color;
+};
+uniform Light lights[MAX_LIGHTS];
+uniform vec4 ambient;
+
+// Clustered point lights, see LightClusters
+uniform sampler2D clusterTable;    // Offset and count, tiles across, slices down
+uniform sampler2D clusterIndices;  // Light indices, 1024 per row
+uniform sampler2D clusterLights;   // Row 0 position and radius, row 1 colour
+uniform mat4 clusterView;
+uniform vec4 clusterGrid;          // Tiles x and y, tile size in pixels
+uniform vec4 clusterDepth;         // Near, far, slice scale and bias
+
+out vec4 finalColor;
+
+void main()
+{
+    vec4 texelColor = texture(texture0, fragTexCoord);
+    vec3 normal = normalize(fragNormal);
+    vec3 viewD = normalize(viewPos - fragPosition);
+    vec3 lightDot = vec3(0.0);
+    vec3 specular = vec3(0.0);
+
+    for (int i = 0; i < MAX_LIGHTS; i++)
+    {
+        if (lights[i].enabled == 1)
+        {
+            vec3 light = normalize(lights[i].position - lights[i].target);
+            float NdotL = max(dot(normal, light), 0.0);
+            lightDot += lights[i].color.rgb * NdotL;
+
+            float specCo = 0.0;
+            if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-light, normal))), 16.0);
+            specular += specCo;
+        }
+    }
+
+    // Find the fragment's cluster and loop over its lights only
+    float depth = -(clusterView*vec4(fragPosition, 1.0)).z;
+    int slices = textureSize(clusterTable, 0).y;
+    int slice = int(log(max(depth, clusterDepth.x))*clusterDepth.z - clusterDepth.w);
+    ivec2 tile = ivec2(gl_FragCoord.xy/clusterGrid.zw);
+    tile = clamp(tile, ivec2(0), ivec2(clusterGrid.xy) - 1);
+    vec3 cluster = texelFetch(clusterTable,
+        ivec2(tile.x + tile.y*int(clusterGrid.x), clamp(slice, 0, slices - 1)), 0).rgb;
+    int first = int(cluster.r);
+    int count = int(cluster.g);
+
+    for (int i = first; i < first + count; i++)
+    {
+        int index = int(texelFetch(clusterIndices, ivec2(i%1024, i/1024), 0).r);
+        vec4 positionRadius = texelFetch(clusterLights, ivec2(index, 0), 0);
+        vec3 color = texelFetch(clusterLights, ivec2(index, 1), 0).rgb;
+
+        vec3 toLight = positionRadius.xyz - fragPosition;
+        float distance = length(toLight);
+        float falloff = clamp(1.0 - distance/positionRadius.w, 0.0, 1.0);
+        falloff *= falloff;
+        vec3 light = toLight/max(distance, 0.0001);
+        float NdotL = max(dot(normal, light), 0.0);
+        lightDot += color*NdotL*falloff;
+
+        if (NdotL > 0.0) specular += color*falloff*pow(max(0.0, dot(viewD, reflect(-light, normal))), 16.0);
+    }
+
+    finalColor = texelColor * ((colDiffuse + vec4(specular, 1.0)) * vec4(lightDot, 1.0));
+    finalColor += texelColor * (ambient * colDiffuse);
+
+    // Gamma correction
+    finalColor = pow(finalColor, vec4(1.0/2.2));
+}
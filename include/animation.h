@@ -1,39 +1,90 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
-#include <map>
+#include <memory>
 #include <string>
 #include <vector>
+#include "animation_library.h"
+#include "pose_cache.h"
 #include "raylib.h"
 #include "settings.h"
+#include "skinning.h"
 
 namespace arena {
 
-struct AnimationInfo {
-    ModelAnimation* animation;
-    const char* name;
+// One clip being played. Newer layers fade in over the older ones.
+struct AnimationLayer {
+    AnimationHandle clip = INVALID_ANIMATION;
+    float frame = 0.0f;
+    float weight = 1.0f;    // Blend weight over the layers below
+    float fadeRate = 0.0f;  // Weight gained per second while fading in
 };
 
+struct AnimationBlendStats {
+    int activeLayers = 0;
+    int droppedLayers = 0;      // Layers cut by the blend layer cap
+    float blendTimeMs = 0.0f;   // Sampling and blending, last update
+    float maxBlendTimeMs = 0.0f;
+};
+
+// Per-character playback cursor over a shared, immutable clip set
 class AnimationManager {
    public:
     AnimationManager(const PlayerSettings& settings);
     virtual ~AnimationManager();
     bool LoadAnimations(const char* filename);
-    void UpdateAnimation(Model& model, float deltaTime);
+    // Loads and compresses a clip set ahead of LoadAnimations, which then
+    // shares it. Safe to call from a loader thread.
+    static std::shared_ptr<const AnimationClipSet> PreloadAnimations(
+        const PlayerSettings& settings, const char* filename);
+    bool BindModel(const Model& model);
+    // CPU half of an update: advance playback, then pose and skin unless
+    // posing is disabled, so throttled characters stay in sync with their
+    // clips. Different managers can animate on different threads.
+    void Animate(float deltaTime);
+    // GPU half, main thread only: upload what Animate() produced
+    void Upload();
+    void UpdateAnimation(float deltaTime) {
+        Animate(deltaTime);
+        Upload();
+    }
+    void SetPoseEnabled(bool enabled) { m_poseEnabled = enabled; }
     void Cleanup();
-    int FindAnimationByName(const char* name) const;
+    AnimationHandle FindAnimationByName(const char* name) const;
+    void SetAnimation(AnimationHandle handle);
     void SetAnimationByName(const std::string& animation);
+    float GetAnimationSpeed(AnimationHandle handle) const;
     float GetAnimationSpeedByName(const std::string& name) const;
+    int GetAnimationCount() const {
+        return m_clips ? m_clips->GetClipCount() : 0;
+    }
+    AnimationHandle GetCurrentAnimation() const {
+        return m_layers.empty() ? INVALID_ANIMATION : m_layers.back().clip;
+    }
+    const AnimationBlendStats& GetBlendStats() const { return m_blendStats; }
+    float GetLastUpdateTimeMs() const { return m_lastUpdateMs; }
 
    private:
+    void advanceLayers(float deltaTime);
+    void samplePose(const AnimationLayer& layer, BoneMatrix* outPalette);
+    void blendLayers();
+
     PlayerSettings m_settings;
-    std::vector<AnimationInfo> m_animations;
-    std::map<std::string, const float> m_animationSpeedValues;
-    ModelAnimation* m_animationData;
-    std::string m_currentAnimName = "idle";
-    float m_animFrameCounter = 0.0f;
+    std::shared_ptr<const AnimationClipSet> m_clips;
+    std::shared_ptr<const PoseCache> m_poses;  // Null when baking is off
+    std::vector<float> m_animationSpeeds;
+    std::vector<AnimationLayer> m_layers;  // Oldest first, current last
+    std::vector<BoneMatrix> m_blendScratch;
+    std::vector<Transform> m_poseScratch;  // Decoded compressed keyframes
+    Model m_model = {0};  // Shallow copy, mesh buffers are owned by Player
+    SkinnedModel m_skinnedModel;
+    bool m_poseEnabled = true;
+    bool m_uploadPending = false;
+    const Transform* m_fallbackPose = nullptr;  // Pose for raylib skinning
+    AnimationBlendStats m_blendStats;
+    float m_lastUpdateMs = 0.0f;  // Cost of the last posed update
 };
 
 }  // namespace arena
 
-#endif  // ANIMATION_H
\ No newline at end of file
+#endif  // ANIMATION_H
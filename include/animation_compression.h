@@ -0,0 +1,76 @@
+#ifndef ANIMATION_COMPRESSION_H
+#define ANIMATION_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+struct ClipCompressionOptions {
+    bool enabled = true;
+    float translationError = 0.001f;  // Max error in model units
+    float rotationError = 0.0005f;    // Max quaternion component error
+    float scaleError = 0.001f;        // Max scale factor error
+};
+
+struct ClipCompressionStats {
+    int keysKept = 0;
+    int keysTotal = 0;
+    size_t rawBytes = 0;
+    size_t compressedBytes = 0;
+    float maxTranslationError = 0.0f;
+    float maxRotationError = 0.0f;
+    float maxScaleError = 0.0f;
+    float decodeNsPerBone = 0.0f;  // Measured over every frame of the clip
+};
+
+// One animation clip with its keys quantized and reduced. Translations
+// and scales are stored as 16-bit fractions of each track's range,
+// rotations as the smallest three quaternion components. Keys that
+// linear interpolation of their neighbours reproduces within the error
+// bounds are dropped, so each track keeps its own sparse key frames.
+class CompressedClip {
+   public:
+    // Compresses every frame of a loaded clip, measuring error and speed
+    CompressedClip(const ModelAnimation& clip,
+                   const ClipCompressionOptions& options);
+
+    // Decode the pose at a frame into boneCount transforms
+    void Sample(const float frame, Transform* outPose) const;
+
+    int GetFrameCount() const { return m_frameCount; }
+    int GetBoneCount() const { return m_boneCount; }
+    size_t GetMemoryBytes() const;
+    const ClipCompressionStats& GetStats() const { return m_stats; }
+
+   private:
+    enum Channel { CHANNEL_TRANSLATION, CHANNEL_ROTATION, CHANNEL_SCALE };
+    static const int CHANNELS = 3;
+
+    struct Track {
+        uint32_t firstKey = 0;
+        uint32_t keyCount = 0;
+        Vector3 minimum = {0, 0, 0};  // Quantization range of vector tracks
+        Vector3 extent = {0, 0, 0};
+    };
+
+    void compressTrack(const ModelAnimation& clip, const int bone,
+                       const Channel channel, const float maxError);
+    Vector4 decodeKey(const Track& track, const Channel channel,
+                      const uint32_t key) const;
+    Vector4 sampleTrack(const Track& track, const Channel channel,
+                        const float frame) const;
+    void measure(const ModelAnimation& clip);
+
+    int m_frameCount = 0;
+    int m_boneCount = 0;
+    std::vector<Track> m_tracks;        // [bone * CHANNELS + channel]
+    std::vector<uint16_t> m_keyFrames;  // Frame of each key
+    std::vector<uint16_t> m_keyData;    // Three quantized values per key
+    ClipCompressionStats m_stats;
+};
+
+}  // namespace arena
+#endif  // ANIMATION_COMPRESSION_H
@@ -0,0 +1,112 @@
+#ifndef ANIMATION_LIBRARY_H
+#define ANIMATION_LIBRARY_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "animation_compression.h"
+#include "raylib.h"
+
+namespace arena {
+
+// Index of an animation clip inside its clip set, resolved once at load
+typedef int AnimationHandle;
+const AnimationHandle INVALID_ANIMATION = -1;
+
+class PoseCache;
+struct PoseBakeOptions;
+
+// Immutable clips loaded from one asset, shared by every character that
+// uses it. Keyframes are released when the last reference goes away.
+// With compression on, the raw keyframes are replaced at load by a
+// CompressedClip per clip and poses are decoded on demand.
+class AnimationClipSet {
+   public:
+    AnimationClipSet(const std::string& path, ModelAnimation* clips,
+                     const int clipCount,
+                     const ClipCompressionOptions& compression);
+    ~AnimationClipSet();
+    AnimationClipSet(const AnimationClipSet&) = delete;
+    AnimationClipSet& operator=(const AnimationClipSet&) = delete;
+
+    AnimationHandle FindClip(const char* name) const;
+    // Name and skeleton of a clip. Its framePoses are released when the
+    // clip is compressed, sample through GetPose() instead.
+    const ModelAnimation& GetClip(AnimationHandle handle) const {
+        return m_clips[handle];
+    }
+    // Pose of a frame. Raw clips return their keyframe directly, compressed
+    // ones are decoded into 'scratch', which holds GetBoneCount() entries.
+    const Transform* GetPose(AnimationHandle handle, const int frame,
+                             Transform* scratch) const;
+    int GetFrameCount(AnimationHandle handle) const {
+        return m_frameCounts[handle];
+    }
+    int GetBoneCount(AnimationHandle handle) const {
+        return m_clips[handle].boneCount;
+    }
+    int GetMaxBoneCount() const;
+    int GetClipCount() const { return m_clipCount; }
+    const std::string& GetPath() const { return m_path; }
+    const ClipCompressionOptions& GetCompression() const {
+        return m_compression;
+    }
+    size_t GetMemoryBytes() const { return m_memoryBytes; }
+
+   private:
+    void compress(const ClipCompressionOptions& options);
+
+    std::string m_path;
+    ClipCompressionOptions m_compression;
+    ModelAnimation* m_clips;
+    int m_clipCount;
+    std::vector<int> m_frameCounts;
+    std::vector<std::unique_ptr<CompressedClip>> m_compressed;  // Or null
+    size_t m_memoryBytes = 0;
+};
+
+// Reference-counted clip cache. Each asset is parsed once per compression
+// setting and its clips baked once per skeleton and bake setting, however
+// many characters play it.
+class AnimationLibrary {
+   public:
+    static std::shared_ptr<const AnimationClipSet> Acquire(
+        const std::string& path, const ClipCompressionOptions& compression);
+    // Baked palettes of a clip set, the model provides the bind pose
+    static std::shared_ptr<const PoseCache> AcquirePoses(
+        const AnimationClipSet& clips, const Model& model,
+        const PoseBakeOptions& options);
+    static int GetLoadedAssetCount();
+    static size_t GetLoadedBytes();
+    static size_t GetBakedBytes();
+
+   private:
+    struct ClipSetKey {
+        std::string path;
+        ClipCompressionOptions compression;
+
+        bool operator<(const ClipSetKey& other) const;
+    };
+
+    struct PoseCacheKey {
+        ClipSetKey clips;
+        float samplesPerFrame;
+        bool quantize;
+        int boneCount;
+        size_t bindPoseHash;  // Models sharing clips can differ in bind pose
+
+        bool operator<(const PoseCacheKey& other) const;
+    };
+
+    static std::map<ClipSetKey, std::weak_ptr<const AnimationClipSet>>
+        clipSets;
+    static std::map<PoseCacheKey, std::weak_ptr<const PoseCache>>
+        poseCaches;
+    static std::mutex mutex;
+};
+
+}  // namespace arena
+#endif  // ANIMATION_LIBRARY_H
@@ -0,0 +1,71 @@
+#ifndef ANIMATION_LOD_H
+#define ANIMATION_LOD_H
+
+#include <vector>
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+enum class AnimationLodTier { Near = 0, Mid, Far };
+const int ANIMATION_LOD_TIERS = 3;
+
+struct AnimationLodStats {
+    int characters[ANIMATION_LOD_TIERS] = {0};  // Characters per tier
+    int updated = 0;            // Characters posed and skinned this frame
+    int throttled = 0;          // Not due this frame at their tier's rate
+    int deferred = 0;           // Due, but over their tier's skin budget
+    float updateTimeMs = 0.0f;  // Measured cost of the updates that ran
+    float savedTimeMs = 0.0f;   // Estimated cost of the skipped updates
+};
+
+// Decides which characters pose and skin their animation this frame.
+// Characters are binned into tiers by distance from the view. Near ones
+// update every frame, mid-range ones every few frames and far ones keep
+// a frozen pose. Each tier skins at most its budget per frame, the most
+// stale characters first, and the rest wait for the next frame.
+class AnimationLodSystem {
+   public:
+    AnimationLodSystem(const AnimationLodSettings& settings);
+
+    int AddCharacter(const Vector3& position);
+    void RemoveCharacter(const int id);
+    void SetPosition(const int id, const Vector3& position);
+
+    // Assign tiers from the view position and pick who updates this frame
+    void Update(const Vector3& viewPosition);
+    bool ShouldUpdate(const int id) const { return m_characters[id].update; }
+    AnimationLodTier GetTier(const int id) const {
+        return m_characters[id].tier;
+    }
+    // Report the measured cost of an update that ran
+    void RecordUpdate(const float milliseconds);
+
+    const AnimationLodStats& GetStats() const { return m_stats; }
+    void ResetFrameStats();
+
+   private:
+    struct Character {
+        Vector3 position = {0, 0, 0};
+        AnimationLodTier tier = AnimationLodTier::Near;
+        int framesSinceUpdate = 0;
+        bool posed = false;  // Has been posed at least once
+        bool update = false;
+        bool active = false;
+    };
+
+    AnimationLodTier classify(const Character& character,
+                              const float distance) const;
+    int updateInterval(const AnimationLodTier tier) const;
+    int skinBudget(const AnimationLodTier tier) const;
+
+    AnimationLodSettings m_settings;
+    std::vector<Character> m_characters;
+    std::vector<int> m_freeIds;
+    std::vector<int> m_due[ANIMATION_LOD_TIERS];
+    float m_averageUpdateMs = 0.0f;
+    AnimationLodStats m_stats;
+};
+
+}  // namespace arena
+#endif  // ANIMATION_LOD_H
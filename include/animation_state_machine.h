@@ -0,0 +1,54 @@
+#ifndef ANIMATION_STATE_MACHINE_H
+#define ANIMATION_STATE_MACHINE_H
+
+#include <vector>
+#include "animation.h"
+
+namespace arena {
+
+// Conditions set by the owner every frame, combined as a bit mask
+enum AnimationCondition : unsigned int {
+    ANIM_CONDITION_AIRBORNE = 1u << 0,
+    ANIM_CONDITION_MOVING = 1u << 1,
+    ANIM_CONDITION_COUNT = 2
+};
+
+struct AnimationStateDesc {
+    const char* name;
+    const char* clip;
+};
+
+// Transitions are tested in declaration order. A null 'from' matches any
+// state and is tested after the transitions of the current state.
+struct AnimationTransitionDesc {
+    const char* from;
+    const char* to;
+    unsigned int requiredConditions;
+    unsigned int blockedConditions;
+};
+
+// Data-driven animation selection. Compile() resolves clip names to
+// handles and precomputes, for every state and every condition mask, the
+// state to move to, so Update() is a single table lookup.
+class AnimationStateMachine {
+   public:
+    bool Compile(const std::vector<AnimationStateDesc>& states,
+                 const std::vector<AnimationTransitionDesc>& transitions,
+                 const AnimationManager& animations,
+                 const char* initialState);
+    AnimationHandle Update(unsigned int conditions);
+    int GetCurrentState() const { return m_currentState; }
+    AnimationHandle GetCurrentClip() const {
+        return m_clips[m_currentState];
+    }
+
+   private:
+    static const int CONDITION_MASKS = 1 << ANIM_CONDITION_COUNT;
+
+    std::vector<AnimationHandle> m_clips;  // Clip per state
+    std::vector<int> m_next;  // [state * CONDITION_MASKS + mask] -> state
+    int m_currentState = 0;
+};
+
+}  // namespace arena
+#endif  // ANIMATION_STATE_MACHINE_H
@@ -0,0 +1,52 @@
+#ifndef ANIMATION_SYSTEM_H
+#define ANIMATION_SYSTEM_H
+
+#include <vector>
+#include "animation.h"
+#include "job_system.h"
+#include "settings.h"
+
+namespace arena {
+
+struct AnimationSystemStats {
+    int instances = 0;
+    int threads = 0;
+    float animateTimeMs = 0.0f;  // Parallel sampling and skinning
+    float uploadTimeMs = 0.0f;   // Serial buffer updates on the main thread
+};
+
+// Plays every registered character's animation once per frame. Sampling,
+// blending and skinning are independent per character and run in
+// batches on the job system; GPU buffer updates follow in a single pass
+// on the main thread.
+class AnimationSystem {
+   public:
+    AnimationSystem(const AnimationSystemSettings& settings, JobSystem& jobs);
+
+    void Add(AnimationManager* animation);
+    void Remove(AnimationManager* animation);
+    void Update(const float deltaTime) {
+        Animate(deltaTime);
+        Upload();
+    }
+    // CPU half, callable from any one thread at a time
+    void Animate(const float deltaTime);
+    // GPU half, main thread only
+    void Upload();
+
+    // Times the CPU half with 1 up to every thread and logs the speedup
+    void MeasureScaling();
+
+    const AnimationSystemStats& GetStats() const { return m_stats; }
+
+   private:
+    double animate(const float deltaTime, const int maxThreads);
+
+    AnimationSystemSettings m_settings;
+    JobSystem& m_jobs;
+    std::vector<AnimationManager*> m_instances;
+    AnimationSystemStats m_stats;
+};
+
+}  // namespace arena
+#endif  // ANIMATION_SYSTEM_H
@@ -0,0 +1,84 @@
+#ifndef AOI_GRID_H
+#define AOI_GRID_H
+
+#include <vector>
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+struct AoiStats {
+    int entityCount = 0;
+    int observerCount = 0;
+    int moves = 0;
+    int cellChanges = 0;
+    int queries = 0;
+    int candidatesTested = 0;
+    double moveTimeMs = 0.0;
+    double queryTimeMs = 0.0;
+};
+
+// Area-of-interest grid. Entities are binned into uniform XZ cells so that
+// visibility queries only touch the cells overlapping the query radius.
+// Observers keep a sorted visible set which is diffed on every Update() to
+// produce enter/leave lists for replication.
+class AoiGrid {
+   public:
+    AoiGrid(const AoiSettings& settings, const TerrainSettings& terrain);
+    int AddEntity(const Vector3& position);
+    void RemoveEntity(const int entityId);
+    void MoveEntity(const int entityId, const Vector3& position);
+    void AddObserver(const int entityId, const float radius);
+    void RemoveObserver(const int entityId);
+    void Update();
+    void QueryRadius(const Vector3& center, const float radius,
+                     std::vector<int>& outEntities) const;
+    bool IsRelevant(const int observerId, const int entityId) const;
+    const std::vector<int>& GetVisibleEntities(const int observerId) const;
+    const std::vector<int>& GetEnteredEntities(const int observerId) const;
+    const std::vector<int>& GetLeftEntities(const int observerId) const;
+    const Vector3& GetPosition(const int entityId) const {
+        return m_entities[entityId].position;
+    }
+    const AoiStats& GetStats() const { return m_stats; }
+    void ResetFrameStats();
+
+   private:
+    struct Entity {
+        Vector3 position = {0};
+        int cell = -1;
+        int slot = -1;  // Index inside the cell list, for O(1) removal
+        int observer = -1;
+        bool active = false;
+    };
+
+    struct Observer {
+        int entityId = -1;
+        float radius = 0.0f;
+        std::vector<int> visible;
+        std::vector<int> entered;
+        std::vector<int> left;
+        std::vector<int> removed;  // Left by removal, reported next Update
+    };
+
+    bool isActive(const int entityId) const;
+    int cellIndex(const Vector3& position) const;
+    void linkToCell(const int entityId, const int cell);
+    void unlinkFromCell(const int entityId);
+
+    AoiSettings m_settings;
+    float m_originX;
+    float m_originZ;
+    int m_cellsX;
+    int m_cellsZ;
+    std::vector<std::vector<int>> m_cells;
+    std::vector<Entity> m_entities;
+    std::vector<int> m_freeEntities;
+    std::vector<Observer> m_observers;
+    std::vector<int> m_scratch;
+    mutable AoiStats m_stats;
+    static const std::vector<int> s_empty;
+};
+
+}  // namespace arena
+#endif  // AOI_GRID_H
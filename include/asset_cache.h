@@ -0,0 +1,47 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace arena {
+
+// Raw bytes of one asset file
+struct AssetBlob {
+    std::string path;
+    std::vector<unsigned char> data;
+};
+
+struct AssetCacheStats {
+    int diskReads = 0;
+    int cacheHits = 0;
+    size_t bytesRead = 0;
+    float readTimeMs = 0.0f;
+};
+
+// Reads each asset file from disk once. Once installed, every raylib file
+// load goes through the cache, so while a blob is held, the model and
+// animation loaders that open the same .glb are served from memory
+// instead of reading the file again.
+class AssetCache {
+   public:
+    static void Install();
+    static std::shared_ptr<const AssetBlob> Acquire(const std::string& path);
+    static AssetCacheStats GetStats();
+
+   private:
+    static unsigned char* loadFileData(const char* fileName, int* dataSize);
+    static bool readFile(const std::string& path,
+                         std::vector<unsigned char>& outData);
+
+    static std::map<std::string, std::weak_ptr<const AssetBlob>> blobs;
+    static std::mutex mutex;
+    static AssetCacheStats stats;
+};
+
+}  // namespace arena
+#endif  // ASSET_CACHE_H
@@ -0,0 +1,59 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+// Runs file reads and CPU-side decoding on loader threads. Each load
+// returns a future; the main thread waits on it and then performs the
+// GPU upload, since GL calls are only valid there.
+class AssetLoader {
+   public:
+    explicit AssetLoader(int threadCount);
+    ~AssetLoader();
+
+    template <typename Work>
+    auto Load(const std::string& name, Work work)
+        -> std::future<decltype(work())>;
+
+   private:
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_quit = false;
+};
+
+template <typename Work>
+auto AssetLoader::Load(const std::string& name, Work work)
+    -> std::future<decltype(work())> {
+    using Result = decltype(work());
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        [name, work]() {
+            utils::Stopwatch timer;
+            Result result = work();
+            LOG_DEBUG("Loaded ", name, " in ", timer.ElapsedMs(),
+                      " ms on a loader thread");
+            return result;
+        });
+    std::future<Result> future = task->get_future();
+    enqueue([task] { (*task)(); });
+    return future;
+}
+
+}  // namespace arena
+#endif  // ASSET_LOADER_H
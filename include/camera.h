@@ -11,12 +11,14 @@ namespace arena {
 class Camera {
    public:
     Camera(const CameraSettings& settings);
+    // Vertical orbit from the mouse, in degrees
+    float SampleInput(const float deltaTime) const;
     void Update(const Vector3& targetPosition,
                 const Vector3& playerFacing,
-                const float deltaTime);
+                const float pitchDelta);
     void UpdateFreeLookCamera(const Vector3& targetPosition,
                               const Vector3& playerFacing,
-                              const float deltaTime);
+                              const float pitchDelta);
     const Camera3D& GetCamera() const { return m_camera; }
     const Vector3& GetPosition() const { return m_camera.position; }
 
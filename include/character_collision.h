@@ -0,0 +1,65 @@
+#ifndef CHARACTER_COLLISION_H
+#define CHARACTER_COLLISION_H
+
+#include <vector>
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+struct CharacterCollisionStats {
+    int characterCount = 0;
+    int sortSwaps = 0;
+    int pairsTested = 0;
+    int contacts = 0;
+    double resolveTimeMs = 0.0;
+};
+
+// Separates overlapping characters modelled as upright capsules. Candidate
+// pairs come from a sort-and-sweep along the X axis. The sorted order is
+// kept between frames and repaired with insertion sort, which is close to
+// linear because characters barely move relative to each other per frame.
+class CharacterCollisionSystem {
+   public:
+    CharacterCollisionSystem(const PhysicsSettings& settings);
+    int AddCharacter(const Vector3& position, const float radius,
+                     const float height);
+    void RemoveCharacter(const int characterId);
+    void SetPosition(const int characterId, const Vector3& position);
+    void Resolve();
+
+    // Offset applied to the character by the last Resolve()
+    Vector3 GetCorrection(const int characterId) const;
+    const Vector3& GetPosition(const int characterId) const {
+        return m_characters[characterId].position;
+    }
+    const CharacterCollisionStats& GetStats() const { return m_stats; }
+
+   private:
+    struct Character {
+        Vector3 position = {0};
+        Vector3 inputPosition = {0};
+        float radius = 0.0f;
+        float height = 0.0f;
+        bool active = false;
+    };
+
+    // Sweep entry, cached so the sweep does not chase character pointers
+    struct SweepEntry {
+        float minX;
+        float maxX;
+        int characterId;
+    };
+
+    void refreshSweepList();
+    void separate(Character& a, Character& b, const int idA, const int idB);
+
+    PhysicsSettings m_settings;
+    std::vector<Character> m_characters;
+    std::vector<int> m_freeCharacters;
+    std::vector<SweepEntry> m_sweep;
+    CharacterCollisionStats m_stats;
+};
+
+}  // namespace arena
+#endif  // CHARACTER_COLLISION_H
@@ -0,0 +1,110 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+class OcclusionCuller;
+
+// View and projection BeginMode3D sets up for the camera, combined
+Matrix GetCameraViewProjection(const Camera3D& camera, const float aspect);
+
+// Six planes (a, b, c, d) with normals pointing into the view volume
+struct Frustum {
+    Vector4 planes[6];
+
+    static Frustum FromMatrix(const Matrix& viewProjection);
+    static Frustum FromCamera(const Camera3D& camera, const float aspect);
+};
+
+struct CullingStats {
+    int objects = 0;
+    int visibleObjects = 0;
+    int culledObjects = 0;
+    int meshes = 0;  // Meshes of every active object
+    int visibleMeshes = 0;
+    int culledMeshes = 0;
+    int boxesTested = 0;
+    int occludedObjects = 0;  // Inside the frustum but hidden
+    int occludedMeshes = 0;
+    float cullTimeMs = 0.0f;
+};
+
+// Culls objects against the view frustum. Each object has one bounding
+// box per mesh in object space plus their union, and a translation.
+// Object boxes are tested first; only objects that straddle a plane have
+// their meshes tested. Boxes are packed as structure-of-arrays, four to a
+// group, and tested a group at a time with SSE where available.
+class CullingSystem {
+   public:
+    int AddObject(const std::vector<BoundingBox>& meshBounds);
+    void RemoveObject(const int id);
+    void SetPosition(const int id, const Vector3& position);
+
+    // Rebuilds the visible list for this frame
+    void Cull(const Frustum& frustum);
+    // Hides objects and meshes left visible by Cull() that the occlusion
+    // buffer proves are hidden
+    void ApplyOcclusion(OcclusionCuller& occlusion);
+
+    bool IsVisible(const int id) const;
+    bool IsMeshVisible(const int id, const int mesh) const;
+    const std::vector<int>& GetVisibleObjects() const { return m_visible; }
+    const CullingStats& GetStats() const { return m_stats; }
+
+   private:
+    struct Object {
+        int firstMesh = 0;
+        int meshCount = 0;
+        int meshCapacity = 0;  // Mesh slots kept when the id is reused
+        bool active = false;
+        bool visible = false;
+    };
+
+    // Boxes as structure-of-arrays, padded to a multiple of four
+    struct PackedBounds {
+        std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+        void Resize(const int count);
+        void Set(const int index, const BoundingBox& box);
+        int Size() const { return (int)minX.size(); }
+    };
+
+    // Outside and straddling flags, one per box
+    struct BoxResults {
+        std::vector<unsigned char> outside;
+        std::vector<unsigned char> straddling;
+    };
+
+    void translate(const PackedBounds& bounds, const int first,
+                   const int count, const float* offsetX,
+                   const float* offsetY, const float* offsetZ,
+                   const int offsetStride, PackedBounds& world);
+    void classify(const Frustum& frustum, const PackedBounds& world,
+                  const int count, BoxResults& results);
+    bool cullMeshes(const Frustum& frustum, const int id);
+    BoundingBox getWorldBounds(const PackedBounds& bounds, const int index,
+                               const int id) const;
+
+    std::vector<Object> m_objects;
+    std::vector<int> m_freeIds;
+    PackedBounds m_objectBounds;  // Union of each object's meshes
+    PackedBounds m_meshBounds;
+    std::vector<float> m_positionX, m_positionY, m_positionZ;
+    std::vector<unsigned char> m_meshVisible;
+
+    // World-space boxes and results of the last test, kept between
+    // frames to avoid allocating
+    PackedBounds m_objectWorld;
+    PackedBounds m_meshWorld;
+    BoxResults m_objectResults;
+    BoxResults m_meshResults;
+
+    std::vector<int> m_visible;
+    CullingStats m_stats;
+};
+
+}  // namespace arena
+#endif  // CULLING_H
@@ -0,0 +1,113 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+// Groups of debug geometry shown or hidden together, as a bit mask
+enum DebugDrawCategory : unsigned int {
+    DEBUG_DRAW_COLLISION = 1u << 0,  // Character boxes and ground probes
+    DEBUG_DRAW_TERRAIN = 1u << 1,    // Colliders and the touched triangle
+    DEBUG_DRAW_LIGHTS = 1u << 2,
+    DEBUG_DRAW_GRID = 1u << 3,
+    DEBUG_DRAW_ALL = (1u << 4) - 1,
+};
+
+#ifdef ARENA_DEBUG_DRAW
+
+// Debug shapes queued from any thread and drawn later in a few batches,
+// one per primitive type. Shapes are double buffered like render
+// packets: those queued while a frame simulates are handed to the render
+// side by Swap() and drawn with that frame. CMake defines
+// ARENA_DEBUG_DRAW for Debug builds, or for every build with the
+// ARENA_DEBUG_DRAW option; other builds get the empty class below.
+class DebugDraw {
+   public:
+    static void SetEnabled(const unsigned int categories, const bool show);
+    static void Toggle(const unsigned int categories);
+    static bool IsEnabled(const unsigned int categories);
+
+    static void Line(const unsigned int category, const Vector3& start,
+                     const Vector3& end, const Color color);
+    static void Triangle(const unsigned int category, const Vector3& v1,
+                         const Vector3& v2, const Vector3& v3,
+                         const Color color);  // Filled, counter-clockwise
+    static void Sphere(const unsigned int category, const Vector3& center,
+                       const float radius, const Color color);  // Wires
+    static void Box(const unsigned int category, const Vector3& center,
+                    const Vector3& size, const Color color);  // Wires
+    // Screen-space label at a world position
+    static void Text(const unsigned int category, const Vector3& position,
+                     const char* text, const Color color);
+
+    // Main thread, between frames: queued shapes become the drawn ones
+    static void Swap();
+    // Draws the handed over shapes, inside BeginMode3D. Returns the
+    // number of batches submitted.
+    static int Flush();
+    // Draws the handed over labels, outside BeginMode3D
+    static int FlushText(const Camera3D& camera);
+
+   private:
+    struct Vertex {
+        Vector3 position;
+        Color color;
+    };
+
+    struct Label {
+        Vector3 position;
+        std::string text;
+        Color color;
+    };
+
+    struct Frame {
+        std::vector<Vertex> lines;      // Two vertices per line
+        std::vector<Vertex> triangles;  // Three vertices per triangle
+        std::vector<Label> labels;
+
+        void Clear();
+    };
+
+    static void addCircle(const Vector3& center, const Vector3& axisU,
+                          const Vector3& axisV, const float radius,
+                          const Color color, std::vector<Vertex>& lines);
+
+    static std::atomic<unsigned int> enabled;
+    static std::mutex mutex;
+    static Frame frames[2];
+    static int queued;  // Frame shapes are queued into
+};
+
+#else
+
+class DebugDraw {
+   public:
+    static void SetEnabled(const unsigned int, const bool) {}
+    static void Toggle(const unsigned int) {}
+    static bool IsEnabled(const unsigned int) { return false; }
+
+    static void Line(const unsigned int, const Vector3&, const Vector3&,
+                     const Color) {}
+    static void Triangle(const unsigned int, const Vector3&, const Vector3&,
+                         const Vector3&, const Color) {}
+    static void Sphere(const unsigned int, const Vector3&, const float,
+                       const Color) {}
+    static void Box(const unsigned int, const Vector3&, const Vector3&,
+                    const Color) {}
+    static void Text(const unsigned int, const Vector3&, const char*,
+                     const Color) {}
+
+    static void Swap() {}
+    static int Flush() { return 0; }
+    static int FlushText(const Camera3D&) { return 0; }
+};
+
+#endif  // ARENA_DEBUG_DRAW
+
+}  // namespace arena
+#endif  // DEBUG_DRAW_H
@@ -0,0 +1,63 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace arena {
+
+struct PipelineStats {
+    float simulationMs = 0.0f;  // Last simulation step
+    float renderMs = 0.0f;      // Main thread work while it ran
+    float overlapMs = 0.0f;     // Time both threads were busy
+    float waitMs = 0.0f;        // Main thread blocked on the simulation
+};
+
+// Runs the simulation of the next frame on a thread of its own while the
+// main thread, which owns the GL context, draws the current one. Only
+// one step is ever in flight: Kick() starts it and Wait() joins it.
+// Without threading, Kick() runs the step inline.
+class FramePipeline {
+   public:
+    typedef std::function<void()> Step;
+
+    explicit FramePipeline(const bool threaded);
+    ~FramePipeline();
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    void Kick(Step step);
+    void Wait();
+
+    // Brackets the main thread's work, for the overlap measurement
+    void BeginRender();
+    void EndRender();
+
+    const PipelineStats& GetStats() const { return m_stats; }
+
+   private:
+    typedef std::chrono::steady_clock Clock;
+
+    void threadLoop();
+    void runStep();
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    Step m_step;
+    bool m_busy = false;
+    bool m_quit = false;
+
+    Clock::time_point m_stepStart;
+    Clock::time_point m_stepEnd;
+    Clock::time_point m_renderStart;
+    Clock::time_point m_renderEnd;
+    PipelineStats m_stats;
+};
+
+}  // namespace arena
+#endif  // FRAME_PIPELINE_H
@@ -2,33 +2,133 @@
 #define GAME_H
 
 #include "animation.h"
+#include "animation_lod.h"
+#include "animation_system.h"
+#include "aoi_grid.h"
 #include "camera.h"
+#include "character_collision.h"
+#include "culling.h"
+#include "debug_draw.h"
+#include "frame_pipeline.h"
 #include "game.h"
+#include "impostor_selector.h"
+#include "impostors.h"
+#include "instancing.h"
+#include "job_system.h"
+#include "lag_compensation.h"
+#include "light_clusters.h"
+#include "occlusion.h"
 #include "player.h"
+#include "prediction.h"
+#include "render_graph.h"
+#include "render_packet.h"
+#include "render_queue.h"
 #include "rlights.h"
 #include "terrain.h"
 #include "settings.h"
 #include "shader_handler.h"
+#include "shared_poses.h"
+#include "utils.h"
 #include <memory>
+#include <vector>
 
 namespace arena {
 
+// Handles of a character inside the crowd systems
+struct CharacterHandles {
+    int aoiId = -1;
+    int historyId = -1;
+    int collisionId = -1;
+    int animationLodId = -1;  // Only characters with animations
+    int cullingId = -1;       // Only characters with a model
+    int impostorId = -1;      // Only bots with a model
+};
+
+struct Bot {
+    std::unique_ptr<Player> player;
+    CharacterHandles handles;
+    PlayerInput input;
+    float wanderTimer = 0.0f;
+};
+
+// Device state sampled on the main thread for one simulation step
+struct FrameInput {
+    float deltaTime = 0.0f;
+    double time = 0.0;
+    PlayerInput player;
+    float cameraPitch = 0.0f;  // Degrees
+    bool fire = false;         // Rewound hitscan from the camera
+};
+
 class Game {
    public:
     bool Initialize();
     void Update();
     void Draw();
-    void DrawLights() const;
+    void DrawLights() const;  // Queued into DebugDraw
     void DrawDebugUi() const;
     void Cleanup();
 
    private:
+    void simulate(const FrameInput& input, RenderPacket& packet);
+    void writeRenderPacket(RenderPacket& packet);
+    const RenderPacket& renderPacket() const {
+        return m_packets[m_renderPacket];
+    }
+    void updatePredictedPlayer(const FrameInput& input,
+                               const Vector3& separation);
+    void recordHitboxes(const float deltaTime);
+    void fireHitscan();
+    void registerCharacter(Player& player, CharacterHandles& handles,
+                           const bool observer);
+    void unregisterCharacter(Player& player, CharacterHandles& handles);
+    void createRenderPasses();
+    void toggleDebugDraw();
+    void createPointLights();
+    void cullScene();
+    bool spawnBots();
+    void despawnBots();
+    void updateBots(const float deltaTime);
+    void applyAnimationLod(Player& player, const CharacterHandles& handles);
+    void recordAnimationLod(const Player& player,
+                            const CharacterHandles& handles);
+
     Settings m_settings;
     std::unique_ptr<Player> m_player;
     std::unique_ptr<Terrain> m_terrain;
     std::unique_ptr<Camera> m_camera;
     std::unique_ptr<ShaderHandler> m_shaderHandler;
+    std::unique_ptr<AoiGrid> m_aoiGrid;
+    std::unique_ptr<LagCompensator> m_lagCompensator;
+    int m_tick = 0;                  // Hitbox history, at the tick rate
+    float m_tickAccumulator = 0.0f;  // Seconds not yet recorded
+    int m_frame = 0;
+    std::unique_ptr<CharacterCollisionSystem> m_characterCollision;
+    std::unique_ptr<AnimationLodSystem> m_animationLod;
+    std::unique_ptr<JobSystem> m_jobs;
+    std::unique_ptr<AnimationSystem> m_animationSystem;
+    CharacterHandles m_playerHandles;
+    std::vector<Bot> m_bots;
+    std::unique_ptr<PredictionClient> m_prediction;
+    std::unique_ptr<LocalAuthority> m_authority;
     Light m_lights[1] = {0};
+    std::vector<PointLight> m_pointLights;
+    std::unique_ptr<LightClusters> m_lightClusters;
+    RenderGraph m_renderGraph;
+    RenderQueue m_renderQueue;
+    CullingSystem m_culling;
+    std::unique_ptr<OcclusionCuller> m_occlusion;
+    std::unique_ptr<InstancedRenderer> m_instancing;
+    std::unique_ptr<SharedPoses> m_sharedPoses;
+    std::unique_ptr<ImpostorSelector> m_impostorSelector;
+    std::unique_ptr<ImpostorRenderer> m_impostors;
+    int m_terrainCullingId = -1;
+    std::unique_ptr<FramePipeline> m_pipeline;
+    RenderPacket m_packets[2];  // One drawn while the other is simulated
+    int m_renderPacket = 0;
+    int m_simulationPacket = 0;
+    utils::Stopwatch m_startupTimer;  // Runs from construction
+    bool m_firstFrameDrawn = false;
 };
 
 }  // namespace arena
@@ -0,0 +1,50 @@
+#ifndef IMPOSTOR_SELECTOR_H
+#define IMPOSTOR_SELECTOR_H
+
+#include <vector>
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+struct ImpostorStats {
+    int characters = 0;  // Characters selected this frame
+    int impostors = 0;   // Of those, drawn as quads
+    int switches = 0;    // Characters that changed between mesh and quad
+    int quads = 0;       // Quads drawn by the renderer
+    int drawCalls = 0;
+};
+
+// Picks, per character, between its mesh and an impostor quad by distance
+// to the viewer, and the atlas view that matches the viewing direction.
+// Runs on the CPU only and needs no GL context.
+class ImpostorSelector {
+   public:
+    explicit ImpostorSelector(const ImpostorSettings& settings);
+
+    int AddCharacter();
+    void RemoveCharacter(const int id);
+
+    // Atlas view to draw the character with, or -1 to draw its mesh.
+    // yaw is the character's rotation about the Y axis, in radians.
+    int Select(const int id, const Vector3& position, const float yaw,
+               const Vector3& viewPosition);
+    // Atlas view closest to the direction the viewer sees the character
+    // from, views are spaced evenly around the character
+    static int GetView(const Vector3& position, const float yaw,
+                       const Vector3& viewPosition, const int viewCount);
+
+    bool IsImpostor(const int id) const { return m_impostor[id] != 0; }
+    void ResetFrameStats();
+    const ImpostorStats& GetStats() const { return m_stats; }
+
+   private:
+    ImpostorSettings m_settings;
+    std::vector<unsigned char> m_impostor;  // Current choice, per id
+    std::vector<unsigned char> m_active;
+    std::vector<int> m_freeIds;
+    ImpostorStats m_stats;
+};
+
+}  // namespace arena
+#endif  // IMPOSTOR_SELECTOR_H
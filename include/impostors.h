@@ -0,0 +1,48 @@
+#ifndef IMPOSTORS_H
+#define IMPOSTORS_H
+
+#include <vector>
+#include "impostor_selector.h"
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+// Character model pre-rendered from evenly spaced angles into one atlas
+// row, and drawn as upright camera-facing quads. All quads share the
+// atlas texture, so a frame's impostors go out as a single batch.
+class ImpostorRenderer {
+   public:
+    explicit ImpostorRenderer(const ImpostorSettings& settings);
+    ~ImpostorRenderer();
+
+    // Renders the model's initial animation pose into the atlas
+    bool Bake(const PlayerSettings& playerSettings);
+
+    void Begin(const Vector3& viewPosition);
+    // position is the centre of the character's collision box
+    void Add(const Vector3& position, const int view);
+    // Draws back to front and returns the number of draw calls
+    int Draw();
+
+    const Texture2D& GetAtlas() const { return m_atlas.texture; }
+    const ImpostorStats& GetStats() const { return m_stats; }
+
+   private:
+    struct Quad {
+        Vector3 position;
+        int view;
+        float distance;  // Squared, to the viewer
+    };
+
+    ImpostorSettings m_settings;
+    RenderTexture2D m_atlas = {0};
+    float m_size = 0.0f;     // World size of the square each view covers
+    Vector3 m_centre = {0};  // View centre relative to the box centre
+    Vector3 m_viewPosition = {0};
+    std::vector<Quad> m_quads;
+    ImpostorStats m_stats;
+};
+
+}  // namespace arena
+#endif  // IMPOSTORS_H
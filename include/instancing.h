@@ -0,0 +1,65 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <map>
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+struct InstancingStats {
+    int instances = 0;         // Meshes submitted this frame
+    int batches = 0;           // Distinct mesh and material pairs
+    int instancedBatches = 0;  // Drawn with DrawMeshInstanced
+    int drawCalls = 0;
+};
+
+// Groups mesh submissions that share vertex buffers and material, and
+// draws each group with a single DrawMeshInstanced call. Grouping runs
+// on the CPU only, so batches can be counted without a GL context; only
+// Load() and Draw() touch GL.
+class InstancedRenderer {
+   public:
+    struct Batch {
+        Mesh mesh;
+        Material material;
+        std::vector<Matrix> transforms;
+    };
+
+    explicit InstancedRenderer(const int minInstances = 2);
+    ~InstancedRenderer();
+
+    bool Load(const char* vertexShaderPath, const char* fragmentShaderPath);
+    void Begin();
+    void Add(const Mesh& mesh, const Material& material,
+             const Matrix& transform);
+    // Every mesh of the model, with its material
+    void AddModel(const Model& model, const Matrix& transform);
+    // Draws and returns the number of draw calls
+    int Draw();
+
+    int GetBatchCount() const { return m_batchCount; }
+    const Batch& GetBatch(const int index) const { return m_batches[index]; }
+    const InstancingStats& GetStats() const { return m_stats; }
+
+   private:
+    // Vertex array, vertex buffer, shader and diffuse texture
+    struct BatchKey {
+        unsigned int vao;
+        unsigned int vbo;
+        unsigned int shader;
+        unsigned int texture;
+
+        bool operator<(const BatchKey& other) const;
+    };
+
+    int m_minInstances;
+    Shader m_shader = {0};
+    std::map<BatchKey, int> m_batchIndex;
+    std::vector<Batch> m_batches;  // Kept between frames for their memory
+    int m_batchCount = 0;
+    InstancingStats m_stats;
+};
+
+}  // namespace arena
+#endif  // INSTANCING_H
@@ -0,0 +1,55 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace arena {
+
+// Fixed pool of worker threads for data-parallel loops. The calling
+// thread takes part in every loop, so a pool without workers simply runs
+// the loop inline.
+class JobSystem {
+   public:
+    typedef std::function<void(int begin, int end)> RangeJob;
+
+    // A worker count of 0 uses one worker per core besides the caller
+    explicit JobSystem(int workerCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Splits [0, count) into batches and runs them on at most 'maxThreads'
+    // threads (0 for all of them). Returns once every batch has finished.
+    void ParallelFor(const int count, const int batchSize, const RangeJob& job,
+                     const int maxThreads = 0);
+
+    int GetWorkerCount() const { return (int)m_workers.size(); }
+    int GetThreadCount() const { return GetWorkerCount() + 1; }
+
+   private:
+    void workerLoop(const int index);
+    void runBatches();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    // Current loop, published under the mutex by bumping the generation
+    const RangeJob* m_job = nullptr;
+    int m_count = 0;
+    int m_batchSize = 1;
+    int m_participants = 0;  // Workers taking part in the current loop
+    int m_busy = 0;          // Participants that have not finished yet
+    unsigned int m_generation = 0;
+    bool m_quit = false;
+    std::atomic<int> m_next{0};
+};
+
+}  // namespace arena
+#endif  // JOB_SYSTEM_H
@@ -0,0 +1,100 @@
+#ifndef LAG_COMPENSATION_H
+#define LAG_COMPENSATION_H
+
+#include <cstddef>
+#include <vector>
+#include "player.h"
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+struct HitboxSample {
+    Vector3 position = {0};
+    float radius = 0.0f;
+    float height = 0.0f;
+    int tick = -1;
+};
+
+struct RewindHit {
+    int entityId = -1;
+    float distance = 0.0f;
+    Vector3 point = {0};
+    Vector3 normal = {0};
+};
+
+struct LagCompensationStats {
+    int entityCount = 0;
+    int historyCapacity = 0;
+    size_t bytesPerEntity = 0;
+    size_t totalBytes = 0;
+    int queries = 0;
+    int candidatesTested = 0;
+    double lastQueryMs = 0.0;
+    double maxQueryMs = 0.0;
+};
+
+// Server-side rewind of character hitboxes. Every tick the collision volume
+// of each entity is written to a fixed size ring, so both memory per entity
+// and the rewind window are bounded. Entities are binned into an XZ grid by
+// the bounds of their whole history, which lets rewound raycasts walk the
+// grid instead of testing every entity.
+class LagCompensator {
+   public:
+    LagCompensator(const LagCompensationSettings& settings,
+                   const TerrainSettings& terrain);
+    int AddEntity();
+    void RemoveEntity(const int entityId);
+    void BeginTick(const int tick);
+    void Record(const int entityId, const PlayerState& state);
+
+    // Raycast against hitboxes as they were at 'tick'. Fractional ticks are
+    // interpolated between the two surrounding samples.
+    bool Raycast(const Ray& ray, const float maxDistance, const float tick,
+                 const int ignoreEntity, RewindHit& outHit);
+    bool GetSample(const int entityId, const float tick,
+                   HitboxSample& outSample) const;
+    int GetOldestTick() const;
+    int GetNewestTick() const { return m_currentTick; }
+    const LagCompensationStats& GetStats() const { return m_stats; }
+    void ResetFrameStats();
+
+   private:
+    struct Entity {
+        bool active = false;
+        int minCellX = 0;
+        int minCellZ = 0;
+        int maxCellX = -1;
+        int maxCellZ = -1;
+        unsigned int queryStamp = 0;
+    };
+
+    HitboxSample& sampleAt(const int entityId, const int slot) {
+        return m_samples[entityId * m_capacity + slot];
+    }
+    const HitboxSample& sampleAt(const int entityId, const int slot) const {
+        return m_samples[entityId * m_capacity + slot];
+    }
+    void updateBroadphase(const int entityId);
+    void linkCells(const int entityId, const bool link);
+    bool testCell(const int cellX, const int cellZ, const Ray& ray,
+                  const float maxDistance, const float tick,
+                  const int ignoreEntity, RewindHit& outHit);
+
+    LagCompensationSettings m_settings;
+    int m_capacity;
+    int m_currentTick = -1;
+    float m_originX;
+    float m_originZ;
+    int m_cellsX;
+    int m_cellsZ;
+    std::vector<HitboxSample> m_samples;
+    std::vector<Entity> m_entities;
+    std::vector<int> m_freeEntities;
+    std::vector<std::vector<int>> m_cells;
+    unsigned int m_queryStamp = 0;
+    LagCompensationStats m_stats;
+};
+
+}  // namespace arena
+#endif  // LAG_COMPENSATION_H
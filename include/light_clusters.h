@@ -0,0 +1,104 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <vector>
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+struct PointLight {
+    Vector3 position = {0.0f, 0.0f, 0.0f};
+    float radius = 1.0f;  // Light falls to zero here
+    Color color = WHITE;
+    float intensity = 1.0f;
+};
+
+struct LightClusterStats {
+    int lights = 0;
+    int visibleLights = 0;  // Touching at least one cluster
+    int assignments = 0;    // Light and cluster pairs
+    int droppedAssignments = 0;  // Over the index buffer size
+    int maxClusterLights = 0;
+    int testedClusters = 0;
+    float buildTimeMs = 0.0f;
+};
+
+// Assigns point lights to a view-space grid of clusters: screen tiles
+// split into depth slices that grow exponentially with distance. Each
+// cluster keeps the list of lights whose sphere touches it, and the
+// lighting shader only loops over the list of the fragment's cluster.
+// Build() is CPU only; Load() and Upload() move the lists into textures
+// the shader reads.
+class LightClusters {
+   public:
+    explicit LightClusters(const LightingSettings& settings);
+    ~LightClusters();
+
+    void Build(const std::vector<PointLight>& lights, const Camera3D& camera,
+               const float aspect);
+
+    // Creates the buffer textures and binds them to the shader
+    bool Load(const Shader& shader);
+    void Upload(const std::vector<PointLight>& lights, const int screenWidth,
+                const int screenHeight);
+
+    int GetClusterCount() const { return (int)m_lightCounts.size(); }
+    int GetClusterIndex(const int x, const int y, const int slice) const {
+        return (slice * m_settings.clusterTilesY + y) *
+                   m_settings.clusterTilesX +
+               x;
+    }
+    int GetSlice(const float depth) const;
+    int GetClusterOffset(const int cluster) const {
+        return m_offsets[cluster];
+    }
+    int GetClusterLightCount(const int cluster) const {
+        return m_lightCounts[cluster];
+    }
+    const std::vector<int>& GetLightIndices() const { return m_indices; }
+    const LightClusterStats& GetStats() const { return m_stats; }
+
+   private:
+    // View-space bounds of every cluster, structure-of-arrays and padded
+    // per slice to a multiple of four. Depth is positive into the view.
+    struct ClusterBounds {
+        std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    };
+
+    void computeBounds(const float fovy, const float aspect);
+    void assignLight(const int light, const Vector3& center,
+                     const float radius);
+
+    LightingSettings m_settings;
+    int m_tilesPerSlice;
+    int m_sliceStride;  // Tiles per slice, padded
+    float m_fovy = 0.0f;
+    float m_aspect = 0.0f;
+    float m_sliceScale;  // Slices per unit of log depth
+    ClusterBounds m_bounds;
+
+    std::vector<int> m_lightCounts;  // Per cluster
+    std::vector<int> m_offsets;      // First index of each cluster
+    std::vector<int> m_indices;      // Light indices, grouped by cluster
+    std::vector<int> m_pairs;        // Cluster, light, cluster, light...
+    std::vector<int> m_hits;         // Scratch for one slice
+    LightClusterStats m_stats;
+
+    // GPU side
+    Shader m_shader = {0};
+    unsigned int m_tableTexture = 0;
+    unsigned int m_indexTexture = 0;
+    unsigned int m_lightTexture = 0;
+    int m_indexRows = 0;
+    std::vector<float> m_tableData;
+    std::vector<float> m_indexData;
+    std::vector<float> m_lightData;
+    int m_viewLoc = -1;
+    int m_gridLoc = -1;
+    int m_depthLoc = -1;
+    Matrix m_view;
+};
+
+}  // namespace arena
+#endif  // LIGHT_CLUSTERS_H
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -40,6 +41,7 @@ class Logger {
     static std::ofstream logFile;
     static bool useFile;
     static bool isInitialized;
+    static std::mutex mutex;  // Loader and job threads log too
     static std::string LevelToString(LogLevel level);
 
     template <typename T>
@@ -69,6 +71,8 @@ void Logger::Log(LogLevel level, const Args&... args) {
     std::ostringstream ss;
     LogRecursive(ss, args...);
 
+    // localtime and the log file are shared between threads
+    std::lock_guard<std::mutex> lock(mutex);
     auto now = std::chrono::system_clock::now();
     auto in_time_t = std::chrono::system_clock::to_time_t(now);
 
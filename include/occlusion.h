@@ -0,0 +1,67 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <vector>
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+struct OcclusionStats {
+    int occluderTriangles = 0;    // Selected at load
+    int rasterizedTriangles = 0;  // In front of the near plane this frame
+    int testedBoxes = 0;
+    int occludedBoxes = 0;
+    float rasterTimeMs = 0.0f;
+    float testTimeMs = 0.0f;
+};
+
+// Software occlusion culling. Large terrain triangles are rasterized on
+// the CPU into a low-resolution buffer holding the nearest occluder per
+// pixel, then reduced into tiles holding the farthest of those. A box is
+// occluded when every tile it covers has occluders nearer than the box's
+// nearest point; tiles that cannot decide are resolved per pixel.
+// Depth is stored as 1/w, which interpolates linearly in screen space;
+// larger values are nearer and empty pixels hold 0.
+class OcclusionCuller {
+   public:
+    explicit OcclusionCuller(const OcclusionSettings& settings);
+
+    // World-space triangle list; triangles below the area threshold are
+    // dropped
+    void SetOccluders(const std::vector<Vector3>& triangles);
+    // Clears the buffer and rasterizes the occluders for this view
+    void Render(const Matrix& viewProjection);
+    bool IsVisible(const BoundingBox& box);
+
+    const OcclusionStats& GetStats() const { return m_stats; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    const std::vector<float>& GetDepth() const { return m_depth; }
+
+   private:
+    struct ScreenVertex {
+        float x;
+        float y;
+        float depth;  // 1/w
+    };
+
+    void rasterizeTriangle(const Vector4* clip);
+    void fillTriangle(const ScreenVertex& v0, const ScreenVertex& v1,
+                      const ScreenVertex& v2);
+    void buildTiles();
+
+    OcclusionSettings m_settings;
+    int m_width;
+    int m_height;
+    int m_tilesX;
+    int m_tilesY;
+    std::vector<Vector3> m_occluders;
+    std::vector<float> m_depth;  // Nearest occluder per pixel
+    std::vector<float> m_tiles;  // Farthest pixel per tile
+    Matrix m_viewProjection;
+    OcclusionStats m_stats;
+};
+
+}  // namespace arena
+#endif  // OCCLUSION_H
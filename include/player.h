@@ -2,6 +2,8 @@
 #define PLAYER_H
 
 #include "animation.h"
+#include "animation_state_machine.h"
+#include "player_simulation.h"
 #include "settings.h"
 #include "terrain.h"
 
@@ -12,63 +14,58 @@
 
 namespace arena {
 
-struct PlayerState {
-
-    Vector3 position;
-    Vector3 velocity = {0};
-    Vector3 facingDirection;
-    Vector3 movement = {0};
-    float rotationHorizontal;
-    float radius;
-    float height;
-    float moveSpeed;
-    float jumpSpeed;
-    bool isGrounded = false;
-    bool isJumping = false;
-    float groundHeight = 0;
-    int lastCollidingTriangleIndex = -1;
-    int collidingTriangleIndex = -1;
-    float timeSinceGrounded = 0.0f;
-
-    PlayerState(const Vector3& pos, const Vector3& facing, const float rotation,
-                const float rad, const float inHeight, const float inMoveSpeed,
-                const float inJumpSpeed)
-        : position(pos),
-          facingDirection(facing),
-          rotationHorizontal(rotation),
-          radius(rad),
-          height(inHeight),
-          moveSpeed(inMoveSpeed),
-          jumpSpeed(inJumpSpeed) {}
-};
+// Simulation-only players keep movement and collision but load no model
+// and no animations, for server-side characters, bots and load tests
+enum class PlayerMode { Full, SimulationOnly };
 
 class Player {
    public:
-    Player(const Settings& settings, Terrain* terrain);
+    Player(const Settings& settings, Terrain* terrain,
+           PlayerMode mode = PlayerMode::Full);
     virtual ~Player();
     bool LoadPlayerModel(const char* modelPath);
-    void Update(float deltaTime, const std::vector<Vector3>& colliders);
-    void Draw() const;
-    void DrawColliders() const;
-    void DrawCollisionBox() const;
-    void DrawGroundHeightIndicator() const;
+    void Update(float deltaTime, const PlayerInput& input);
+    PlayerInput SampleInput(float deltaTime) const;
+    // Draw another copy of our model, posed elsewhere, instead of our own.
+    // Null draws our own; a shared model must outlive its use here.
+    void SetSharedModel(const Model* model) { m_sharedModel = model; }
+    // The model the character is drawn with and where it is placed
+    const Model& GetDrawnModel() const {
+        return m_sharedModel ? *m_sharedModel : m_model;
+    }
+    Matrix GetModelTransform() const;
+    // Debug shapes, queued into DebugDraw
+    static void DrawCollisionBox(const PlayerState& state);
+    static void DrawGroundHeightIndicator(const PlayerState& state);
     bool Initialize();
+    // Refused where the terrain would block the push
+    void ApplySeparation(const Vector3& offset);
     const PlayerState& GetState() const { return m_state; }
+    void SetState(const PlayerState& state) { m_state = state; }
+    const PlayerSimulation& GetSimulation() const { return m_simulation; }
+    PlayerMode GetMode() const { return m_mode; }
+    // Model bounds relative to the player position, for culling
+    const BoundingBox& GetBounds() const { return m_bounds; }
+    // Update() only selects clips, playback is advanced for every
+    // character at once by the AnimationSystem
+    AnimationManager* GetAnimationManager() { return m_animManager.get(); }
+    const AnimationManager* GetAnimationManager() const {
+        return m_animManager.get();
+    }
+    // Animation LOD: when off, playback advances without posing the model
+    void SetAnimationUpdate(bool enabled);
 
    private:
-    void checkCollisions(Vector3& newPosition);
-    void updateAnimations(const Vector3& direction) const;
-    void calculateFacingDirection(const float delta);
-
-    // Apply movement vector to direction. Returns the relative move.
-    Vector3 moveToFacingDirection(const float delta,
-                                  const Vector3& moveDirection);
-
-    void updateVelocity(const float delta, const Vector3& relativeMove);
+    void updateAnimations(const Vector3& direction);
 
-    Model m_model;
+    Model m_model = {0};
+    const Model* m_sharedModel = nullptr;
+    BoundingBox m_bounds = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+    PlayerMode m_mode;
     PlayerState m_state;
+    PlayerSimulation m_simulation;
     std::unique_ptr<AnimationManager> m_animManager;
+    AnimationStateMachine m_animStateMachine;
     Settings m_appSettings;
     PlayerSettings m_settings;
     Vector3 m_playerPosition;
@@ -77,7 +74,6 @@ class Player {
     const float MOVE_SPEED = 2.0f;
     const float PLAYER_RADIUS = 0.5f;
     const float PLAYER_HEIGHT = 1.0f;
-    Terrain* m_terrain;
 };
 }  // namespace arena
 #endif  // PLAYER_H
\ No newline at end of file
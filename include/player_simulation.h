@@ -0,0 +1,80 @@
+#ifndef PLAYER_SIMULATION_H
+#define PLAYER_SIMULATION_H
+
+#include "settings.h"
+#include "terrain.h"
+
+#include "raylib.h"
+#include "raymath.h"
+
+namespace arena {
+
+struct PlayerState {
+
+    Vector3 position;
+    Vector3 velocity = {0};
+    Vector3 facingDirection;
+    Vector3 movement = {0};
+    float rotationHorizontal;
+    float radius;
+    float height;
+    float moveSpeed;
+    float jumpSpeed;
+    bool isGrounded = false;
+    bool isJumping = false;
+    float groundHeight = 0;
+    int lastCollidingTriangleIndex = -1;
+    int collidingTriangleIndex = -1;
+    float timeSinceGrounded = 0.0f;
+
+    PlayerState(const Vector3& pos, const Vector3& facing, const float rotation,
+                const float rad, const float inHeight, const float inMoveSpeed,
+                const float inJumpSpeed)
+        : position(pos),
+          facingDirection(facing),
+          rotationHorizontal(rotation),
+          radius(rad),
+          height(inHeight),
+          moveSpeed(inMoveSpeed),
+          jumpSpeed(inJumpSpeed) {}
+};
+
+// Everything the simulation needs from the local devices for one step
+struct PlayerInput {
+    Vector3 moveDirection = {0};  // x: forward/back, z: strafe
+    float rotationDelta = 0.0f;   // Facing rotation around Y, in degrees
+    bool jump = false;
+};
+
+// Deterministic player movement step. Reads no devices and no global
+// timers, so the same state, input and delta produce the same result on
+// the client and on the authoritative side.
+class PlayerSimulation {
+   public:
+    PlayerSimulation(const Settings& settings, const Terrain* terrain);
+    void Simulate(PlayerState& state, const PlayerInput& input,
+                  const float deltaTime) const;
+    // Horizontal push from outside the movement step, such as character
+    // separation. Refused, leaving the state untouched, when the terrain
+    // at the destination is a wall or a step the character cannot climb.
+    bool Displace(PlayerState& state, const Vector3& offset) const;
+
+   private:
+    void calculateFacingDirection(PlayerState& state,
+                                  const PlayerInput& input) const;
+
+    // Apply movement vector to direction. Returns the relative move.
+    Vector3 moveToFacingDirection(PlayerState& state, const float delta,
+                                  const Vector3& moveDirection) const;
+
+    void updateVelocity(PlayerState& state, const float delta,
+                        const Vector3& relativeMove) const;
+    void checkCollisions(PlayerState& state, Vector3& newPosition,
+                         const float delta) const;
+
+    Settings m_settings;
+    const Terrain* m_terrain;
+};
+
+}  // namespace arena
+#endif  // PLAYER_SIMULATION_H
@@ -0,0 +1,74 @@
+#ifndef POSE_CACHE_H
+#define POSE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "animation_library.h"
+#include "raylib.h"
+#include "skinning.h"
+
+namespace arena {
+
+struct PoseBakeOptions {
+    float samplesPerFrame = 1.0f;  // Baked palettes per source keyframe
+    bool quantize = false;         // Store palettes as 16-bit fixed point
+};
+
+// Bone palette stored as 16-bit fixed point, scaled per clip
+struct QuantizedBoneMatrix {
+    int16_t position[12];
+    int16_t normal[12];
+};
+
+// Every clip of a clip set pre-sampled into contiguous, frame-indexed bone
+// palettes at load. Posing a character is then a lookup into this table,
+// and characters on the same sample share the same palette memory.
+class PoseCache {
+   public:
+    PoseCache(const Model& model, const AnimationClipSet& clips,
+              const PoseBakeOptions& options);
+    PoseCache(const PoseCache&) = delete;
+    PoseCache& operator=(const PoseCache&) = delete;
+
+    // Palette of an exact baked sample, shared by every character on it.
+    // Returns nullptr for quantized caches, use Sample() for those.
+    const BoneMatrix* GetPalette(AnimationHandle clip, int sample) const;
+
+    // Palette at a fractional source frame, optionally lerped between the
+    // two nearest samples. Wraps around the end of the clip.
+    void Sample(AnimationHandle clip, float frame, bool interpolate,
+                BoneMatrix* outPalette) const;
+
+    // Index of the sample nearest below a fractional source frame
+    int GetSampleIndex(AnimationHandle clip, float frame) const;
+    int GetSampleCount(AnimationHandle clip) const {
+        return m_clips[clip].sampleCount;
+    }
+    int GetBoneCount() const { return m_boneCount; }
+    bool IsQuantized() const { return m_options.quantize; }
+    size_t GetMemoryBytes() const;
+
+   private:
+    struct BakedClip {
+        int sampleCount = 0;
+        size_t firstPalette = 0;  // Index of sample 0 in the palette arrays
+        float positionScale = 1.0f;     // Quantization step of the 3x3 part
+        float translationScale = 1.0f;  // Quantization step of translations
+    };
+
+    int bakeClip(const Model& model, const AnimationClipSet& clips,
+                 const AnimationHandle clip,
+                 std::vector<BoneMatrix>& outPalettes) const;
+    void quantizeClip(const std::vector<BoneMatrix>& palettes,
+                      BakedClip& outClip);
+
+    PoseBakeOptions m_options;
+    int m_boneCount = 0;
+    std::vector<BakedClip> m_clips;
+    std::vector<BoneMatrix> m_palettes;  // [firstPalette + sample * bones]
+    std::vector<QuantizedBoneMatrix> m_quantized;
+};
+
+}  // namespace arena
+#endif  // POSE_CACHE_H
@@ -0,0 +1,98 @@
+#ifndef PREDICTION_H
+#define PREDICTION_H
+
+#include <deque>
+#include "player_simulation.h"
+#include "settings.h"
+
+namespace arena {
+
+struct InputCommand {
+    unsigned int sequence = 0;
+    PlayerInput input;
+    float deltaTime = 0.0f;
+    // Character separation applied after the step. Part of the predicted
+    // state, so the authority and replays apply the same push.
+    Vector3 separation = {0};
+};
+
+struct StateSnapshot {
+    unsigned int lastProcessedSequence = 0;
+    PlayerState state;
+
+    StateSnapshot(const PlayerState& inState) : state(inState) {}
+};
+
+struct PredictionStats {
+    int pendingInputs = 0;
+    int snapshotsReceived = 0;
+    int mispredictions = 0;
+    int replayedInputs = 0;
+    float lastError = 0.0f;
+    double reconcileTimeMs = 0.0;  // Cost of the last frame's reconciliation
+    float MispredictionRate() const {
+        return snapshotsReceived > 0
+                   ? (float)mispredictions / (float)snapshotsReceived
+                   : 0.0f;
+    }
+};
+
+// In-process stand-in for the authoritative server. Commands and snapshots
+// are held back by an injectable one-way latency before being delivered.
+class LocalAuthority {
+   public:
+    LocalAuthority(const PlayerSimulation& simulation,
+                   const PlayerState& initialState, const float latency);
+    void Send(const InputCommand& command, const double now);
+    void Update(const double now);
+    bool ReceiveSnapshot(const double now, StateSnapshot& outSnapshot);
+    void SetLatency(const float latency) { m_latency = latency; }
+
+   private:
+    template <typename T>
+    struct Delayed {
+        double deliveryTime;
+        T payload;
+    };
+
+    const PlayerSimulation& m_simulation;
+    StateSnapshot m_authoritative;
+    float m_latency;
+    std::deque<Delayed<InputCommand>> m_incoming;
+    std::deque<Delayed<StateSnapshot>> m_outgoing;
+};
+
+// Client-side prediction. Inputs are simulated immediately and kept until
+// the authority acknowledges them. When a snapshot disagrees with what was
+// predicted for that input, the client rewinds to the snapshot and replays
+// every input that is still unacknowledged.
+class PredictionClient {
+   public:
+    PredictionClient(const NetworkSettings& settings,
+                     const PlayerSimulation& simulation);
+    InputCommand CreateCommand(const PlayerInput& input,
+                               const float deltaTime,
+                               const Vector3& separation);
+    void StorePrediction(const InputCommand& command,
+                         const PlayerState& predicted);
+
+    // Returns true if 'inOutState' was corrected
+    bool Reconcile(const StateSnapshot& snapshot, PlayerState& inOutState);
+    const PredictionStats& GetStats() const { return m_stats; }
+    void ResetFrameStats() { m_stats.reconcileTimeMs = 0.0; }
+
+   private:
+    struct PendingInput {
+        InputCommand command;
+        PlayerState predicted;
+    };
+
+    NetworkSettings m_settings;
+    const PlayerSimulation& m_simulation;
+    unsigned int m_nextSequence = 1;
+    std::deque<PendingInput> m_pending;
+    PredictionStats m_stats;
+};
+
+}  // namespace arena
+#endif  // PREDICTION_H
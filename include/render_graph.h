@@ -0,0 +1,54 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+// State a pass reads, combined as a bit mask. Passes without the camera
+// draw in screen space.
+enum RenderInput : unsigned int {
+    RENDER_INPUT_CAMERA = 1u << 0,    // Inside BeginMode3D
+    RENDER_INPUT_LIGHTING = 1u << 1,  // Inside the lighting shader
+};
+
+struct RenderPassStats {
+    std::string name;
+    int drawCalls = 0;
+    float timeMs = 0.0f;  // CPU submission, including the batch flush
+};
+
+// Runs every registered pass exactly once per frame. Passes are grouped
+// by the state they read, so the camera and the lighting shader are each
+// bound once, and a pass name can only be registered once.
+class RenderGraph {
+   public:
+    // Draws the pass and returns the number of draw calls it submitted;
+    // immediate-mode geometry counts as the single batch it flushes
+    using PassFunction = std::function<int()>;
+
+    bool AddPass(const std::string& name, unsigned int inputs,
+                 PassFunction execute);
+    void Execute(const Camera3D& camera, const Shader& lighting);
+
+    const std::vector<RenderPassStats>& GetStats() const { return m_stats; }
+    int GetDrawCalls() const;
+    float GetTimeMs() const;
+
+   private:
+    struct RenderPass {
+        unsigned int inputs;
+        PassFunction execute;
+    };
+
+    void runPasses(const unsigned int inputs);
+
+    std::vector<RenderPass> m_passes;
+    std::vector<RenderPassStats> m_stats;  // Parallel to m_passes
+};
+
+}  // namespace arena
+#endif  // RENDER_GRAPH_H
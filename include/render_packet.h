@@ -0,0 +1,57 @@
+#ifndef RENDER_PACKET_H
+#define RENDER_PACKET_H
+
+#include <vector>
+#include "animation.h"
+#include "animation_lod.h"
+#include "animation_system.h"
+#include "aoi_grid.h"
+#include "character_collision.h"
+#include "impostors.h"
+#include "lag_compensation.h"
+#include "player_simulation.h"
+#include "prediction.h"
+#include "raylib.h"
+
+namespace arena {
+
+// A character model placed for drawing. The model's GPU buffers were
+// updated before the packet was handed to the render thread.
+struct CharacterDraw {
+    const Model* model = nullptr;
+    Matrix transform;
+    Vector3 position = {0.0f, 0.0f, 0.0f};  // Culling and sort depth
+    int cullingId = -1;
+    bool instanced = false;
+    int impostorView = -1;  // Atlas view to draw instead of the model
+};
+
+// Copies of the simulation's statistics for the debug overlay
+struct SimulationStats {
+    AoiStats aoi;
+    int aoiVisible = 0;  // Entities the local player sees
+    LagCompensationStats lagCompensation;
+    CharacterCollisionStats characterCollision;
+    bool prediction = false;
+    PredictionStats predictionStats;
+    bool playerAnimated = false;
+    AnimationBlendStats blend;
+    AnimationLodStats animationLod;
+    AnimationSystemStats animationSystem;
+    ImpostorStats impostors;
+};
+
+// Everything the render thread reads of one simulated frame. The
+// simulation writes one packet while the previous one is being drawn.
+struct RenderPacket {
+    int frame = 0;
+    Camera3D camera = {0};
+    PlayerState player = PlayerState(Vector3{0.0f, 0.0f, 0.0f},
+                                     Vector3{1.0f, 0.0f, 0.0f}, 0.0f, 0.0f,
+                                     0.0f, 0.0f, 0.0f);  // Local player
+    std::vector<CharacterDraw> characters;
+    SimulationStats stats;
+};
+
+}  // namespace arena
+#endif  // RENDER_PACKET_H
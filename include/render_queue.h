@@ -0,0 +1,72 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+struct RenderQueueStats {
+    int items = 0;
+    int stateChangesBefore = 0;  // Shader and texture switches as queued
+    int stateChangesAfter = 0;   // The same, in sorted order
+    int sortPasses = 0;          // Radix passes that were not skipped
+    float sortTimeMs = 0.0f;
+};
+
+// Collects mesh draws for a frame and submits them ordered by a 64-bit
+// key: pass, then shader, then diffuse texture, then distance from the
+// view, nearest first. Items sharing state end up adjacent and opaque
+// geometry is drawn front to back. Sorting needs no GL context.
+class RenderQueue {
+   public:
+    // Pass in the top 4 bits, shader id in the next 12, texture id in the
+    // next 16 and the distance's float bits, which order like the
+    // distance itself while it is positive, in the low 32
+    static uint64_t MakeKey(const unsigned int pass, const unsigned int shader,
+                            const unsigned int texture, const float distance);
+
+    void Begin(const Vector3& viewPosition);
+    // Position orders the item by distance, usually its bounds' centre
+    void Add(const unsigned int pass, const Mesh& mesh,
+             const Material& material, const Matrix& transform,
+             const Vector3& position);
+    // Every mesh of the model, with its material
+    void AddModel(const unsigned int pass, const Model& model,
+                  const Matrix& transform, const Vector3& position);
+    void Sort();
+    // Draws in sorted order and returns the draw calls
+    int Draw() const;
+
+    int GetCount() const { return (int)m_items.size(); }
+    // Index into the queued items of the nth item in sorted order
+    int GetSortedIndex(const int n) const { return m_order[n].index; }
+    uint64_t GetSortedKey(const int n) const { return m_order[n].key; }
+    const RenderQueueStats& GetStats() const { return m_stats; }
+
+   private:
+    struct DrawItem {
+        Mesh mesh;
+        Material material;
+        Matrix transform;
+    };
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    int radixSort();
+    int countStateChanges(const bool sorted) const;
+
+    Vector3 m_viewPosition = {0.0f, 0.0f, 0.0f};
+    // Kept between frames to avoid allocating
+    std::vector<DrawItem> m_items;
+    std::vector<SortEntry> m_order;
+    std::vector<SortEntry> m_scratch;
+    RenderQueueStats m_stats;
+};
+
+}  // namespace arena
+#endif  // RENDER_QUEUE_H
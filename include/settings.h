@@ -33,6 +33,39 @@ struct PlayerSettings {
     const float movementThreshold = 0.001f;
     const float velocityThreshold = 0.001f;
     const float defaultAnimationSpeed = 50.0f;
+    const bool bakeAnimationPoses = true;        // Pre-sample clips at load
+    const float poseBakeSamplesPerFrame = 1.0f;  // Baked poses per keyframe
+    const bool quantizeBakedPoses = false;       // 16-bit palettes
+    const bool interpolateBakedPoses = true;     // Lerp between baked poses
+    const float animationFadeTime = 0.2f;  // Cross-fade between clips, seconds
+    const int maxBlendLayers = 3;          // Clips blended at once, caps cost
+    const bool compressAnimations = true;  // Quantize and reduce clip keys
+    const float animationPositionError = 0.001f;   // Compression bounds
+    const float animationRotationError = 0.0005f;  // Quaternion component
+    const float animationScaleError = 0.001f;      // Fraction of the scale
+};
+
+struct AnimationLodSettings {
+    const float nearDistance = 15.0f;  // Full-rate animation inside this
+    const float midDistance = 40.0f;   // Reduced rate up to here, then frozen
+    const float hysteresis = 2.0f;     // Distance past a boundary to switch
+    const int midUpdateInterval = 3;   // Frames between mid-range updates
+    const int farUpdateInterval = 0;   // 0 keeps far characters frozen
+    const int nearSkinBudget = 64;     // Characters skinned per frame, per tier
+    const int midSkinBudget = 32;
+    const int farSkinBudget = 8;
+};
+
+struct AnimationSystemSettings {
+    const int batchSize = 2;              // Characters per job batch
+    const bool measureScaling = false;    // Log thread scaling at startup
+    const int scalingIterations = 20;     // Timed runs per thread count
+};
+
+struct JobSettings {
+    const int workerThreads = 0;       // 0 uses one worker per extra core
+    const int loaderThreads = 2;       // Asset reads and decoding at startup
+    const bool pipelineFrames = true;  // Simulate while the last frame draws
 };
 
 struct TerrainSettings {
@@ -42,19 +75,104 @@ struct TerrainSettings {
     const float collisionHysteresis = 0.05f;
 };
 
+struct OcclusionSettings {
+    const bool enabled = true;
+    const int bufferWidth = 320;         // Depth buffer, in pixels
+    const int bufferHeight = 180;
+    const int tileSize = 8;              // Hierarchical-Z tile, in pixels
+    const float minOccluderArea = 1.0f;  // Smaller terrain triangles skipped
+};
+
+struct LightingSettings {
+    const bool clustered = true;        // Point lights through clusters
+    const int pointLights = 32;         // Scattered over the map
+    const float pointLightRadius = 12.0f;
+    const float pointLightHeight = 2.0f;
+    const int clusterTilesX = 16;       // Screen tiles across
+    const int clusterTilesY = 9;
+    const int clusterSlices = 24;       // Exponential depth slices
+    const float clusterNear = 0.5f;     // Depth range the slices cover
+    const float clusterFar = 150.0f;
+    const int maxPointLights = 256;     // Light buffer size
+    const int maxLightIndices = 16384;  // Cluster light list size
+};
+
+struct InstancingSettings {
+    const bool enabled = true;
+    const int minInstances = 2;       // Smaller batches draw mesh by mesh
+    const bool shareFarPoses = true;  // Far characters draw a shared pose
+};
+
+struct ImpostorSettings {
+    const bool enabled = true;
+    const float distance = 60.0f;   // Characters beyond draw as quads
+    const float hysteresis = 4.0f;  // Distance past the switch to change
+    const int viewAngles = 8;       // Atlas views around the character
+    const int cellSize = 128;       // Atlas pixels per view
+};
+
 struct PhysicsSettings {
     const float gravity = -9.8f;
     const float collisionGroundCheckDistance = 0.1f;
     const float airControl = 0.3f;    // Reduced control in air
     const float airFriction = 0.99f;  // Slight friction in air
+    const int characterSeparationIterations = 2;
+};
+
+struct AoiSettings {
+    const float cellSize = 10.0f;    // Grid cell size on the XZ plane
+    const float viewRadius = 40.0f;  // Default observer visibility radius
+};
+
+struct LagCompensationSettings {
+    const float historyDuration = 0.5f;  // Rewindable history in seconds
+    const int tickRate = 60;             // Simulation ticks per second
+    const int maxEntities = 256;         // Upper bound for history memory
+    const float cellSize = 4.0f;         // Broadphase cell size on XZ plane
+    const float hitscanRange = 100.0f;   // Debug shot on right click
+};
+
+struct NetworkSettings {
+    const bool enablePrediction = true;      // Use local authority stand-in
+    const float simulatedLatency = 0.1f;     // One-way latency in seconds
+    const float reconcileTolerance = 0.01f;  // Allowed position error
+    const int maxPendingInputs = 128;        // Unacknowledged input budget
+};
+
+struct BotSettings {
+    const int count = 0;                // Simulation-only bots for load tests
+    const float spawnRadius = 20.0f;    // Around the initial player position
+    const float wanderInterval = 2.0f;  // Seconds between direction changes
+    const bool animated = false;        // Load models and animate bots
+};
+
+// Only apply when ARENA_DEBUG_DRAW is defined: Debug builds, or any
+// build with the ARENA_DEBUG_DRAW CMake option
+struct DebugDrawSettings {
+    const bool collision = true;
+    const bool terrain = true;
+    const bool lights = true;
+    const bool grid = true;
 };
 
 struct Settings {
     WindowSettings windowSettings;
     CameraSettings cameraSettings;
     PlayerSettings playerSettings;
+    AnimationLodSettings animationLodSettings;
+    AnimationSystemSettings animationSystemSettings;
+    JobSettings jobSettings;
     TerrainSettings terrainSettings;
+    OcclusionSettings occlusionSettings;
+    LightingSettings lightingSettings;
+    InstancingSettings instancingSettings;
+    ImpostorSettings impostorSettings;
     PhysicsSettings physicsSettings;
+    AoiSettings aoiSettings;
+    LagCompensationSettings lagCompensationSettings;
+    NetworkSettings networkSettings;
+    BotSettings botSettings;
+    DebugDrawSettings debugDrawSettings;
 };
 
 }  // namespace arena
@@ -1,30 +1,48 @@
 #ifndef SHADER_HANDLER_H
 #define SHADER_HANDLER_H
 
-#include "camera.h"
+#include <map>
+#include <vector>
 #include "settings.h"
 #include "raylib.h"
+#include "rlights.h"
 
 namespace arena {
 
 #define GLSL_VERSION 330
 
+struct ShaderUniformStats {
+    int uploaded = 0;  // Uniforms sent to the GPU this frame
+    int skipped = 0;   // Uniforms already holding the same value
+};
+
 class ShaderHandler {
    public:
-    ShaderHandler(const Settings& settings, Camera* camera);
+    explicit ShaderHandler(const Settings& settings);
     virtual ~ShaderHandler();
     bool Load(const char* vertexShaderPath, const char* fragmentShaderPath);
     void Begin();
     void End();
-    void Update();
     const Shader& GetShader() const { return m_shader; }
     void SetCameraPosition(const Vector3& position);
+    void SetLight(const Light& light);
+    const ShaderUniformStats& GetStats() const { return m_stats; }
+    void ResetFrameStats();
 
 
    private:
+    // Upload a uniform only when it differs from the last value sent to
+    // the same location
+    void setUniform(int location, const float* value, int count,
+                    int uniformType);
+    void setUniformInt(int location, int value);
+    void setUniformMatrix(int location, const Matrix& value);
+    bool updateCache(int location, const float* value, int count);
+
     Settings m_settings;
     Shader m_shader;
-    Camera* m_camera;
+    std::map<int, std::vector<float>> m_uniforms;  // Location -> last value
+    ShaderUniformStats m_stats;
 
 };
 
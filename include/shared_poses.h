@@ -0,0 +1,39 @@
+#ifndef SHARED_POSES_H
+#define SHARED_POSES_H
+
+#include <memory>
+#include <vector>
+#include "animation.h"
+#include "animation_system.h"
+#include "raylib.h"
+#include "settings.h"
+
+namespace arena {
+
+// One copy of the character model per clip, each playing its clip on a
+// loop. Characters skinned on the CPU own unique vertex buffers and can
+// never be instanced; distant characters draw the copy of their current
+// clip instead, so those playing the same clip share buffers.
+class SharedPoses {
+   public:
+    SharedPoses(const PlayerSettings& settings, AnimationSystem& animations);
+    ~SharedPoses();
+
+    bool Initialize();
+    // Model posed by the clip, null when there is none
+    const Model* GetModel(const AnimationHandle clip) const;
+    int GetCount() const { return (int)m_poses.size(); }
+
+   private:
+    struct Pose {
+        Model model = {0};
+        std::unique_ptr<AnimationManager> animation;
+    };
+
+    PlayerSettings m_settings;
+    AnimationSystem& m_animations;
+    std::vector<Pose> m_poses;  // Indexed by clip
+};
+
+}  // namespace arena
+#endif  // SHARED_POSES_H
@@ -0,0 +1,75 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <vector>
+#include "raylib.h"
+
+namespace arena {
+
+// Bone transform in skinning space. Rows are (x, y, z, translation) so a
+// row can be loaded straight into one SIMD register. Normals use the
+// rotation only, matching raylib's UpdateModelAnimation.
+struct BoneMatrix {
+    float position[12];
+    float normal[12];
+};
+
+// Bind-pose vertex data of one mesh, split into SoA streams
+struct SkinnedMeshStreams {
+    int vertexCount = 0;
+    bool hasNormals = false;
+    std::vector<float> px, py, pz;
+    std::vector<float> nx, ny, nz;
+    std::vector<unsigned char> boneIds;  // 4 per vertex
+    std::vector<float> boneWeights;      // 4 per vertex
+};
+
+// CPU skinning of one model instance. The pose is turned into a bone
+// palette once per update, then vertices are skinned four at a time with
+// SSE. Skin() works on vertex ranges so the work can be split across
+// threads, and Upload() only touches the dynamic position/normal buffers.
+class SkinnedModel {
+   public:
+    bool Initialize(const Model& model);
+    bool IsInitialized() const { return !m_meshes.empty(); }
+
+    // Build the palette from model-space bone transforms (framePoses)
+    void SetPose(const Transform* pose);
+    void SetPalette(const std::vector<BoneMatrix>& palette);
+    const std::vector<BoneMatrix>& GetPalette() const { return m_palette; }
+    // Skin from an external palette, e.g. a baked pose shared between
+    // characters. It must stay alive until the next Skin() call.
+    void UsePalette(const BoneMatrix* palette) { m_activePalette = palette; }
+    // Per-instance palette storage sized to the skeleton
+    BoneMatrix* GetPaletteBuffer() { return m_palette.data(); }
+
+    void Skin(const int meshIndex, const int firstVertex, const int lastVertex);
+    void SkinAll();
+    void Upload();
+
+    int GetMeshCount() const { return (int)m_meshes.size(); }
+    int GetVertexCount(const int meshIndex) const {
+        return m_meshes[meshIndex].vertexCount;
+    }
+
+    const Model& GetModel() const { return m_model; }
+
+    static void ComputePalette(const Model& model, const Transform* pose,
+                               std::vector<BoneMatrix>& outPalette);
+    static void ComputePalette(const Model& model, const Transform* pose,
+                               BoneMatrix* outPalette);
+    // out = from + (to - from) * weight over whole palettes, out may alias
+    static void BlendPalettes(const BoneMatrix* from, const BoneMatrix* to,
+                              const float weight, const int boneCount,
+                              BoneMatrix* outPalette);
+
+   private:
+    Model m_model = {0};  // Shallow copy, mesh buffers are owned by Player
+    std::vector<SkinnedMeshStreams> m_meshes;
+    std::vector<int> m_meshIndices;  // Model mesh index of each stream set
+    std::vector<BoneMatrix> m_palette;
+    const BoneMatrix* m_activePalette = nullptr;
+};
+
+}  // namespace arena
+#endif  // SKINNING_H
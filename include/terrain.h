@@ -2,7 +2,9 @@
 #define TERRAIN_H
 
 #include <vector>
+#include "culling.h"
 #include "raylib.h"
+#include "render_queue.h"
 #include "settings.h"
 
 namespace arena {
@@ -12,14 +14,23 @@ class Terrain {
     Terrain(const TerrainSettings& settings);
     virtual ~Terrain();
     bool LoadTerrainModel(const char* modelPath);
-    void Draw();
+    // Draws every material with the shader, which the caller keeps loaded
+    void SetShader(const Shader& shader);
+    // Queues the meshes culling left visible, returns how many
+    int Submit(RenderQueue& queue, const unsigned int pass,
+               const CullingSystem& culling, const int cullingId) const;
+    // World-space bounds of each mesh
+    const std::vector<BoundingBox>& GetMeshBounds() const {
+        return m_meshBounds;
+    }
+    // Queued into DebugDraw
     void DrawCollidingTriangle(const int triangleIndex,
-                               const Vector3& colliderPosition);
+                               const Vector3& colliderPosition) const;
     void DrawColliderFaces() const;
     void DrawColliderEdges() const;
-    std::pair<float, int> CheckCollision(const Vector3& position,
-                                         const float radius, const float height,
-                                         int& outLastCollidingTriangleIndex);
+    std::pair<float, int> CheckCollision(
+        const Vector3& position, const float radius, const float height,
+        int& outLastCollidingTriangleIndex) const;
     bool Initialize();
     const std::vector<Vector3>& GetColliders() const { return m_colliders; }
     Vector3 GetTriangleNormal(const int triangleIndex) const;
@@ -27,10 +38,14 @@ class Terrain {
                                         float radius) const;
 
    private:
+    void computeMeshBounds();
+
     TerrainSettings m_settings;
     Model m_model;
     const char* m_modelPath;
     std::vector<Vector3> m_colliders;
+    std::vector<BoundingBox> m_meshBounds;
+    bool m_customShader = false;
 };
 }  // namespace arena
 #endif  // TERRAIN_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <chrono>
 #include <vector>
 #include "raylib.h"
 #include "raymath.h"
@@ -27,6 +28,32 @@ bool CheckCollisionSphereTriangle(const Vector3& center, const float radius,
                                   const Vector3& v1, const Vector3& v2,
                                   const Vector3& v3, float& collisionHeight);
 
+// Function to check collision between a ray and a capsule defined by the
+// segment 'a'-'b'. Ray direction must be normalized.
+bool GetRayCollisionCapsule(const Ray& ray, const Vector3& a, const Vector3& b,
+                            const float radius, RayCollision& outCollision);
+
+// Function to find the closest points between segments 'p1'-'q1' and
+// 'p2'-'q2'. Closest points are returned in 'outC1' and 'outC2'
+void ClosestPointsSegmentSegment(const Vector3& p1, const Vector3& q1,
+                                 const Vector3& p2, const Vector3& q2,
+                                 Vector3& outC1, Vector3& outC2);
+
+// Wall-clock stopwatch used for per-frame metrics
+class Stopwatch {
+   public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+    void Reset() { m_start = std::chrono::steady_clock::now(); }
+    double ElapsedMs() const {
+        return std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - m_start)
+            .count();
+    }
+
+   private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
 }  // namespace utils
 }  // namespace arena
 #endif  // UTILS_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "animation.h"
 #include "logger.h"
+#include "utils.h"
+#include <algorithm>
 #include <iostream>
 
 
@@ -11,73 +13,235 @@ AnimationManager::~AnimationManager() {
     Cleanup();
 }
 
+std::shared_ptr<const AnimationClipSet> AnimationManager::PreloadAnimations(
+    const PlayerSettings& settings, const char* filename) {
+    ClipCompressionOptions compression;
+    compression.enabled = settings.compressAnimations;
+    compression.translationError = settings.animationPositionError;
+    compression.scaleError = settings.animationScaleError;
+    compression.rotationError = settings.animationRotationError;
+    return AnimationLibrary::Acquire(filename, compression);
+}
+
 bool AnimationManager::LoadAnimations(const char* filename) {
-    int animCount = 0;
-    m_animationData = LoadModelAnimations(filename, &animCount);
-    if (m_animationData == nullptr || animCount == 0) {
+    m_clips = PreloadAnimations(m_settings, filename);
+    if (!m_clips) {
         LOG_ERROR("Failed to load animations for player model.");
         return false;
+    }
+
+    m_animationSpeeds.assign(m_clips->GetClipCount(),
+                             m_settings.defaultAnimationSpeed);
+    m_poseScratch.resize(std::max(m_clips->GetMaxBoneCount(), 1));
+
+    // Resolve the initial animation once, fall back to the first clip
+    AnimationLayer initial;
+    initial.clip =
+        FindAnimationByName(m_settings.initialAnimationName.c_str());
+    if (initial.clip == INVALID_ANIMATION) {
+        LOG_WARNING("Initial animation not found: ",
+                    m_settings.initialAnimationName);
+        initial.clip = 0;
+    }
+    m_layers.reserve(std::max(m_settings.maxBlendLayers, 1));
+    m_layers.assign(1, initial);
+    return true;
+}
+
+bool AnimationManager::BindModel(const Model& model) {
+    m_model = model;
+    m_poseScratch.resize(std::max((int)m_poseScratch.size(), model.boneCount));
+    if (!m_skinnedModel.Initialize(model)) {
+        LOG_WARNING("Model has no skinned meshes, using raylib animation");
+        return false;
+    }
+
+    if (m_settings.bakeAnimationPoses && m_clips) {
+        PoseBakeOptions options;
+        options.samplesPerFrame = m_settings.poseBakeSamplesPerFrame;
+        options.quantize = m_settings.quantizeBakedPoses;
+        m_poses = AnimationLibrary::AcquirePoses(*m_clips, model, options);
+    }
+    m_blendScratch.resize(std::max(model.boneCount, 1));
+    return true;
+}
+
+void AnimationManager::SetAnimation(AnimationHandle handle) {
+    if (handle < 0 || handle >= GetAnimationCount()) {
+        LOG_ERROR("Invalid animation handle: ", handle);
+        return;
+    }
+    if (!m_layers.empty() && m_layers.back().clip == handle)
+        return;
+
+    // Restart the new clip and fade it in over whatever is playing
+    AnimationLayer layer;
+    layer.clip = handle;
+    if (m_layers.empty() || m_settings.animationFadeTime <= 0.0f ||
+        !m_skinnedModel.IsInitialized()) {
+        m_layers.assign(1, layer);
+        return;
+    }
+    layer.weight = 0.0f;
+    layer.fadeRate = 1.0f / m_settings.animationFadeTime;
+
+    // Bound the per-character cost, the oldest layer becomes opaque base
+    const int maxLayers = std::max(m_settings.maxBlendLayers, 1);
+    while ((int)m_layers.size() >= maxLayers) {
+        m_layers.erase(m_layers.begin());
+        m_blendStats.droppedLayers++;
+    }
+    if (m_layers.empty()) {
+        layer.weight = 1.0f;
     } else {
-        for (int i = 0; i < animCount; i++) {
-            m_animations.push_back({&m_animationData[i], m_animationData[i].name});
-            m_animationSpeedValues.insert(
-                std::make_pair(std::string(m_animationData[i].name),
-                               m_settings.defaultAnimationSpeed));
-            LOG_DEBUG("Loaded animation: ", m_animationData[i].name);
-        }
+        m_layers.front().weight = 1.0f;
     }
+    m_layers.push_back(layer);
 }
 
 void AnimationManager::SetAnimationByName(const std::string& animation) {
-    m_currentAnimName = animation;
+    SetAnimation(FindAnimationByName(animation.c_str()));
 }
 
-float AnimationManager::GetAnimationSpeedByName(const std::string& name) const {
-    auto it = m_animationSpeedValues.find(name);
-    if (it != m_animationSpeedValues.end()) {
-        return it->second;
+float AnimationManager::GetAnimationSpeed(AnimationHandle handle) const {
+    if (handle >= 0 && handle < (int)m_animationSpeeds.size()) {
+        return m_animationSpeeds[handle];
     }
 
     return m_settings.defaultAnimationSpeed;
 }
 
-void AnimationManager::UpdateAnimation(Model& model, float deltaTime) {
-    // Update animation
-    int currentAnimIndex =
-        FindAnimationByName(m_currentAnimName.c_str());
-    if (currentAnimIndex == -1) {
-        LOG_ERROR("Animation not found !");
-        currentAnimIndex = 0;  // Use the first animation as a fallback
-    }
-
-    m_animFrameCounter +=
-        deltaTime * GetAnimationSpeedByName(m_currentAnimName);
-    if (currentAnimIndex >= 0 && currentAnimIndex < m_animations.size()) {
-        UpdateModelAnimation(model,
-                             *m_animations[currentAnimIndex].animation,
-                             m_animFrameCounter);
-        if (m_animFrameCounter >=
-            m_animations[currentAnimIndex].animation->frameCount) {
-            m_animFrameCounter = 0;
-        }
+float AnimationManager::GetAnimationSpeedByName(const std::string& name) const {
+    return GetAnimationSpeed(FindAnimationByName(name.c_str()));
+}
+
+void AnimationManager::Animate(float deltaTime) {
+    if (m_layers.empty())
+        return;
+
+    advanceLayers(deltaTime);
+    if (!m_poseEnabled)
+        return;
+
+    utils::Stopwatch timer;
+    const AnimationLayer& current = m_layers.back();
+    m_uploadPending = true;
+
+    if (!m_skinnedModel.IsInitialized()) {
+        // raylib skins on upload, only decode the pose here
+        m_fallbackPose = m_clips->GetPose(current.clip, (int)current.frame,
+                                          m_poseScratch.data());
+        m_lastUpdateMs = timer.ElapsedMs();
+        return;
     }
+
+    if (m_layers.size() > 1) {
+        blendLayers();
+    } else if (!m_poses) {
+        m_skinnedModel.SetPose(m_clips->GetPose(
+            current.clip, (int)current.frame, m_poseScratch.data()));
+    } else if (!m_settings.interpolateBakedPoses && !m_poses->IsQuantized()) {
+        // Characters on the same sample skin from the same baked palette
+        int sample = m_poses->GetSampleIndex(current.clip, current.frame);
+        m_skinnedModel.UsePalette(m_poses->GetPalette(current.clip, sample));
+    } else {
+        BoneMatrix* palette = m_skinnedModel.GetPaletteBuffer();
+        samplePose(current, palette);
+        m_skinnedModel.UsePalette(palette);
+    }
+
+    // Vectorized skinning, the upload happens later on the main thread
+    m_skinnedModel.SkinAll();
+    m_lastUpdateMs = timer.ElapsedMs();
 }
 
-void AnimationManager::Cleanup() {
-    for (auto& anim : m_animations) {
-        UnloadModelAnimation(*anim.animation);
+void AnimationManager::Upload() {
+    if (!m_uploadPending)
+        return;
+    m_uploadPending = false;
+
+    if (m_skinnedModel.IsInitialized()) {
+        // Only the animated streams change
+        m_skinnedModel.Upload();
+        return;
     }
-    m_animations.clear();
-    RL_FREE(m_animationData);
+
+    // raylib skins a single frame, hand it the decoded pose
+    ModelAnimation frame = m_clips->GetClip(m_layers.back().clip);
+    Transform* framePose = const_cast<Transform*>(m_fallbackPose);
+    frame.frameCount = 1;
+    frame.framePoses = &framePose;
+    UpdateModelAnimation(m_model, frame, 0);
 }
 
-int AnimationManager::FindAnimationByName(const char* name) const {
-    for (size_t i = 0; i < m_animations.size(); i++) {
-        if (strcmp(m_animations[i].name, name) == 0) {
-            return i;
+void AnimationManager::advanceLayers(float deltaTime) {
+    // Fading layers keep playing underneath the one fading in
+    for (AnimationLayer& layer : m_layers) {
+        layer.frame += deltaTime * m_animationSpeeds[layer.clip];
+        if (layer.frame >= m_clips->GetFrameCount(layer.clip)) {
+            layer.frame = 0;
+        }
+        layer.weight =
+            std::min(1.0f, layer.weight + deltaTime * layer.fadeRate);
+    }
+
+    // A fully faded-in layer hides everything below it, stop blending those
+    for (int i = (int)m_layers.size() - 1; i > 0; i--) {
+        if (m_layers[i].weight >= 1.0f) {
+            m_layers.erase(m_layers.begin(), m_layers.begin() + i);
+            break;
         }
     }
-    return -1;  // Animation not found
+    m_blendStats.activeLayers = (int)m_layers.size();
+    if (m_layers.size() == 1)
+        m_blendStats.blendTimeMs = 0.0f;
+}
+
+void AnimationManager::samplePose(const AnimationLayer& layer,
+                                  BoneMatrix* outPalette) {
+    if (m_poses) {
+        m_poses->Sample(layer.clip, layer.frame,
+                        m_settings.interpolateBakedPoses, outPalette);
+        return;
+    }
+    SkinnedModel::ComputePalette(
+        m_skinnedModel.GetModel(),
+        m_clips->GetPose(layer.clip, (int)layer.frame, m_poseScratch.data()),
+        outPalette);
+}
+
+void AnimationManager::blendLayers() {
+    utils::Stopwatch timer;
+    const int boneCount = (int)m_blendScratch.size();
+    BoneMatrix* palette = m_skinnedModel.GetPaletteBuffer();
+
+    // Blend bottom up, each layer over the result of the ones below
+    samplePose(m_layers.front(), palette);
+    for (size_t i = 1; i < m_layers.size(); i++) {
+        samplePose(m_layers[i], m_blendScratch.data());
+        SkinnedModel::BlendPalettes(palette, m_blendScratch.data(),
+                                    m_layers[i].weight, boneCount, palette);
+    }
+    m_skinnedModel.UsePalette(palette);
+
+    m_blendStats.blendTimeMs = timer.ElapsedMs();
+    m_blendStats.maxBlendTimeMs =
+        std::max(m_blendStats.maxBlendTimeMs, m_blendStats.blendTimeMs);
+}
+
+void AnimationManager::Cleanup() {
+    // Releases our reference, the library unloads unused clips
+    m_clips.reset();
+    m_poses.reset();
+    m_animationSpeeds.clear();
+    m_poseScratch.clear();
+    m_layers.clear();
+    m_uploadPending = false;
+    m_fallbackPose = nullptr;
+}
+
+AnimationHandle AnimationManager::FindAnimationByName(const char* name) const {
+    return m_clips ? m_clips->FindClip(name) : INVALID_ANIMATION;
 }
 
-}  // namespace arena
\ No newline at end of file
+}  // namespace arena
@@ -0,0 +1,289 @@
+#include "animation_compression.h"
+#include <algorithm>
+#include <cmath>
+#include "raymath.h"
+#include "utils.h"
+
+namespace arena {
+
+static const float SQRT2 = 1.41421356f;
+
+static Vector4 rotationValue(const Quaternion& q) {
+    return QuaternionNormalize(q);
+}
+
+static Vector4 vectorValue(const Vector3& v) {
+    return Vector4{v.x, v.y, v.z, 0.0f};
+}
+
+// Interpolates like the runtime decoder: lerp, or nlerp on the shortest
+// arc for rotations
+static Vector4 interpolate(Vector4 a, Vector4 b, const float t,
+                           const bool rotation) {
+    if (!rotation) {
+        return Vector4{a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+                       a.z + (b.z - a.z) * t, 0.0f};
+    }
+    if (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f)
+        b = Vector4{-b.x, -b.y, -b.z, -b.w};
+    return QuaternionNormalize(QuaternionLerp(a, b, t));
+}
+
+static float error(const Vector4& value, Vector4 reference,
+                   const bool rotation) {
+    // q and -q are the same rotation
+    if (rotation && value.x * reference.x + value.y * reference.y +
+                            value.z * reference.z + value.w * reference.w <
+                        0.0f) {
+        reference = Vector4{-reference.x, -reference.y, -reference.z,
+                            -reference.w};
+    }
+    return std::max(std::max(std::fabs(value.x - reference.x),
+                             std::fabs(value.y - reference.y)),
+                    std::max(std::fabs(value.z - reference.z),
+                             std::fabs(value.w - reference.w)));
+}
+
+// Smallest three: drop the largest component, which is made positive and
+// rebuilt from the unit length. The other three fit in [-1/√2, 1/√2] and
+// take 15 bits each, the dropped index is kept in the two spare bits.
+static void encodeRotation(const Vector4& q, uint16_t* out) {
+    const float c[4] = {q.x, q.y, q.z, q.w};
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (std::fabs(c[i]) > std::fabs(c[largest]))
+            largest = i;
+    }
+    const float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float n = (c[i] * sign * SQRT2 + 1.0f) * 0.5f;
+        n = std::max(0.0f, std::min(1.0f, n));
+        out[k++] = (uint16_t)std::lround(n * 32767.0f);
+    }
+    out[0] |= (uint16_t)((largest & 1) << 15);
+    out[1] |= (uint16_t)((largest >> 1) << 15);
+}
+
+static Vector4 decodeRotation(const uint16_t* in) {
+    const int largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+    float v[3];
+    float sum = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        v[k] = ((in[k] & 0x7fff) / 32767.0f * 2.0f - 1.0f) / SQRT2;
+        sum += v[k] * v[k];
+    }
+
+    float c[4];
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        c[i] = i == largest ? std::sqrt(std::max(0.0f, 1.0f - sum)) : v[k++];
+    }
+    return Vector4{c[0], c[1], c[2], c[3]};
+}
+
+static void encodeVector(const Vector4& value, const Vector3& minimum,
+                         const Vector3& extent, uint16_t* out) {
+    const float v[3] = {value.x, value.y, value.z};
+    const float lo[3] = {minimum.x, minimum.y, minimum.z};
+    const float range[3] = {extent.x, extent.y, extent.z};
+    for (int i = 0; i < 3; i++) {
+        float n = range[i] > 0.0f ? (v[i] - lo[i]) / range[i] : 0.0f;
+        n = std::max(0.0f, std::min(1.0f, n));
+        out[i] = (uint16_t)std::lround(n * 65535.0f);
+    }
+}
+
+static Vector4 decodeVector(const uint16_t* in, const Vector3& minimum,
+                            const Vector3& extent) {
+    const float scale = 1.0f / 65535.0f;
+    return Vector4{minimum.x + in[0] * scale * extent.x,
+                   minimum.y + in[1] * scale * extent.y,
+                   minimum.z + in[2] * scale * extent.z, 0.0f};
+}
+
+CompressedClip::CompressedClip(const ModelAnimation& clip,
+                               const ClipCompressionOptions& options)
+    : m_frameCount(clip.frameCount), m_boneCount(clip.boneCount) {
+    m_tracks.resize((size_t)m_boneCount * CHANNELS);
+    for (int bone = 0; bone < m_boneCount; bone++) {
+        compressTrack(clip, bone, CHANNEL_TRANSLATION,
+                      options.translationError);
+        compressTrack(clip, bone, CHANNEL_ROTATION, options.rotationError);
+        compressTrack(clip, bone, CHANNEL_SCALE, options.scaleError);
+    }
+
+    m_stats.keysKept = (int)m_keyFrames.size();
+    m_stats.keysTotal = m_frameCount * m_boneCount * CHANNELS;
+    m_stats.rawBytes =
+        m_frameCount * (sizeof(Transform*) + m_boneCount * sizeof(Transform));
+    m_stats.compressedBytes = GetMemoryBytes();
+    measure(clip);
+}
+
+void CompressedClip::compressTrack(const ModelAnimation& clip, const int bone,
+                                   const Channel channel,
+                                   const float maxError) {
+    const bool rotation = channel == CHANNEL_ROTATION;
+    const int frames = m_frameCount;
+    Track& track = m_tracks[bone * CHANNELS + channel];
+
+    std::vector<Vector4> raw(frames);
+    for (int f = 0; f < frames; f++) {
+        const Transform& transform = clip.framePoses[f][bone];
+        raw[f] = channel == CHANNEL_TRANSLATION
+                     ? vectorValue(transform.translation)
+                 : rotation ? rotationValue(transform.rotation)
+                            : vectorValue(transform.scale);
+    }
+
+    if (!rotation && frames > 0) {
+        Vector3 lo = {raw[0].x, raw[0].y, raw[0].z};
+        Vector3 hi = lo;
+        for (const Vector4& value : raw) {
+            lo = Vector3Min(lo, Vector3{value.x, value.y, value.z});
+            hi = Vector3Max(hi, Vector3{value.x, value.y, value.z});
+        }
+        track.minimum = lo;
+        track.extent = Vector3Subtract(hi, lo);
+    }
+
+    // Quantize every frame first, so key reduction sees decoded values
+    std::vector<uint16_t> quantized((size_t)frames * 3);
+    std::vector<Vector4> decoded(frames);
+    for (int f = 0; f < frames; f++) {
+        uint16_t* q = &quantized[f * 3];
+        if (rotation) {
+            encodeRotation(raw[f], q);
+            decoded[f] = decodeRotation(q);
+        } else {
+            encodeVector(raw[f], track.minimum, track.extent, q);
+            decoded[f] = decodeVector(q, track.minimum, track.extent);
+        }
+    }
+
+    // A constant track needs a single key
+    std::vector<int> keys(1, 0);
+    bool constant = true;
+    for (int f = 1; f < frames && constant; f++) {
+        constant = error(decoded[0], raw[f], rotation) <= maxError;
+    }
+
+    // Otherwise extend each segment until interpolating its end points no
+    // longer reproduces every frame in between
+    if (!constant) {
+        int anchor = 0;
+        for (int end = 2; end < frames; end++) {
+            bool fits = true;
+            for (int f = anchor + 1; f < end && fits; f++) {
+                float t = (float)(f - anchor) / (end - anchor);
+                fits = error(interpolate(decoded[anchor], decoded[end], t,
+                                         rotation),
+                             raw[f], rotation) <= maxError;
+            }
+            if (!fits) {
+                anchor = end - 1;
+                keys.push_back(anchor);
+            }
+        }
+        keys.push_back(frames - 1);
+    }
+
+    track.firstKey = (uint32_t)m_keyFrames.size();
+    track.keyCount = (uint32_t)keys.size();
+    for (int key : keys) {
+        m_keyFrames.push_back((uint16_t)key);
+        m_keyData.insert(m_keyData.end(), &quantized[key * 3],
+                         &quantized[key * 3] + 3);
+    }
+}
+
+Vector4 CompressedClip::decodeKey(const Track& track, const Channel channel,
+                                  const uint32_t key) const {
+    const uint16_t* data = &m_keyData[(track.firstKey + key) * 3];
+    return channel == CHANNEL_ROTATION
+               ? decodeRotation(data)
+               : decodeVector(data, track.minimum, track.extent);
+}
+
+Vector4 CompressedClip::sampleTrack(const Track& track, const Channel channel,
+                                    const float frame) const {
+    if (track.keyCount == 1)
+        return decodeKey(track, channel, 0);
+
+    // First key past the frame, the segment ends there
+    const uint16_t* frames = &m_keyFrames[track.firstKey];
+    const uint32_t next =
+        (uint32_t)(std::upper_bound(frames, frames + track.keyCount, frame) -
+                   frames);
+    if (next == 0)
+        return decodeKey(track, channel, 0);
+    if (next == track.keyCount)
+        return decodeKey(track, channel, track.keyCount - 1);
+
+    const uint32_t previous = next - 1;
+    const float t =
+        (frame - frames[previous]) / (float)(frames[next] - frames[previous]);
+    return interpolate(decodeKey(track, channel, previous),
+                       decodeKey(track, channel, next), t,
+                       channel == CHANNEL_ROTATION);
+}
+
+void CompressedClip::Sample(const float frame, Transform* outPose) const {
+    for (int bone = 0; bone < m_boneCount; bone++) {
+        const Track* tracks = &m_tracks[bone * CHANNELS];
+        Vector4 translation = sampleTrack(tracks[CHANNEL_TRANSLATION],
+                                          CHANNEL_TRANSLATION, frame);
+        Vector4 scale =
+            sampleTrack(tracks[CHANNEL_SCALE], CHANNEL_SCALE, frame);
+        outPose[bone].translation =
+            Vector3{translation.x, translation.y, translation.z};
+        outPose[bone].rotation =
+            sampleTrack(tracks[CHANNEL_ROTATION], CHANNEL_ROTATION, frame);
+        outPose[bone].scale = Vector3{scale.x, scale.y, scale.z};
+    }
+}
+
+void CompressedClip::measure(const ModelAnimation& clip) {
+    std::vector<Transform> pose(m_boneCount);
+
+    utils::Stopwatch timer;
+    for (int f = 0; f < m_frameCount; f++) {
+        Sample((float)f, pose.data());
+    }
+    const double elapsedMs = timer.ElapsedMs();
+    if (m_frameCount > 0 && m_boneCount > 0) {
+        m_stats.decodeNsPerBone =
+            (float)(elapsedMs * 1.0e6 / ((double)m_frameCount * m_boneCount));
+    }
+
+    for (int f = 0; f < m_frameCount; f++) {
+        Sample((float)f, pose.data());
+        for (int bone = 0; bone < m_boneCount; bone++) {
+            const Transform& reference = clip.framePoses[f][bone];
+            m_stats.maxTranslationError = std::max(
+                m_stats.maxTranslationError,
+                error(vectorValue(pose[bone].translation),
+                      vectorValue(reference.translation), false));
+            m_stats.maxRotationError = std::max(
+                m_stats.maxRotationError,
+                error(pose[bone].rotation, rotationValue(reference.rotation),
+                      true));
+            m_stats.maxScaleError =
+                std::max(m_stats.maxScaleError,
+                         error(vectorValue(pose[bone].scale),
+                               vectorValue(reference.scale), false));
+        }
+    }
+}
+
+size_t CompressedClip::GetMemoryBytes() const {
+    return sizeof(CompressedClip) + m_tracks.size() * sizeof(Track) +
+           m_keyFrames.size() * sizeof(uint16_t) +
+           m_keyData.size() * sizeof(uint16_t);
+}
+
+}  // namespace arena
@@ -0,0 +1,224 @@
+#include "animation_library.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include "logger.h"
+#include "pose_cache.h"
+
+namespace arena {
+
+std::map<AnimationLibrary::ClipSetKey,
+         std::weak_ptr<const AnimationClipSet>>
+    AnimationLibrary::clipSets;
+std::map<AnimationLibrary::PoseCacheKey, std::weak_ptr<const PoseCache>>
+    AnimationLibrary::poseCaches;
+std::mutex AnimationLibrary::mutex;
+
+bool AnimationLibrary::ClipSetKey::operator<(const ClipSetKey& other) const {
+    return std::tie(path, compression.enabled, compression.translationError,
+                    compression.rotationError, compression.scaleError) <
+           std::tie(other.path, other.compression.enabled,
+                    other.compression.translationError,
+                    other.compression.rotationError,
+                    other.compression.scaleError);
+}
+
+bool AnimationLibrary::PoseCacheKey::operator<(
+    const PoseCacheKey& other) const {
+    if (clips < other.clips)
+        return true;
+    if (other.clips < clips)
+        return false;
+    return std::tie(samplesPerFrame, quantize, boneCount, bindPoseHash) <
+           std::tie(other.samplesPerFrame, other.quantize, other.boneCount,
+                    other.bindPoseHash);
+}
+
+// FNV-1a over the bind pose transforms
+static size_t hashBindPose(const Model& model) {
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char* bytes = (const unsigned char*)model.bindPose;
+    const size_t size = model.boneCount * sizeof(Transform);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return (size_t)hash;
+}
+
+AnimationClipSet::AnimationClipSet(const std::string& path,
+                                   ModelAnimation* clips, const int clipCount,
+                                   const ClipCompressionOptions& compression)
+    : m_path(path),
+      m_compression(compression),
+      m_clips(clips),
+      m_clipCount(clipCount),
+      m_compressed(clipCount) {
+    for (int i = 0; i < clipCount; i++) {
+        m_frameCounts.push_back(clips[i].frameCount);
+    }
+    if (compression.enabled)
+        compress(compression);
+
+    for (int i = 0; i < clipCount; i++) {
+        const ModelAnimation& clip = clips[i];
+        m_memoryBytes +=
+            sizeof(ModelAnimation) + clip.boneCount * sizeof(BoneInfo);
+        if (m_compressed[i]) {
+            m_memoryBytes += m_compressed[i]->GetMemoryBytes();
+        } else {
+            m_memoryBytes +=
+                clip.frameCount *
+                (sizeof(Transform*) + clip.boneCount * sizeof(Transform));
+        }
+    }
+}
+
+void AnimationClipSet::compress(const ClipCompressionOptions& options) {
+    for (int i = 0; i < m_clipCount; i++) {
+        ModelAnimation& clip = m_clips[i];
+        // Key frames are stored as 16-bit indices
+        if (clip.frameCount <= 0 || clip.boneCount <= 0 ||
+            clip.frameCount > 65535) {
+            continue;
+        }
+
+        m_compressed[i] = std::make_unique<CompressedClip>(clip, options);
+        const ClipCompressionStats& stats = m_compressed[i]->GetStats();
+        LOG_INFO("Compressed clip '", clip.name, "': ", stats.keysKept, "/",
+                 stats.keysTotal, " keys, ", stats.rawBytes, " -> ",
+                 stats.compressedBytes, " bytes, max error ",
+                 stats.maxTranslationError, "/", stats.maxRotationError, "/",
+                 stats.maxScaleError, ", decode ", stats.decodeNsPerBone,
+                 " ns/bone");
+
+        // Release the raw keyframes. The frame count goes to zero so that
+        // UnloadModelAnimations only frees what is left.
+        for (int f = 0; f < clip.frameCount; f++) {
+            MemFree(clip.framePoses[f]);
+        }
+        MemFree(clip.framePoses);
+        clip.framePoses = nullptr;
+        clip.frameCount = 0;
+    }
+}
+AnimationClipSet::~AnimationClipSet() {
+    LOG_DEBUG("Unloading animation clips: ", m_path);
+    UnloadModelAnimations(m_clips, m_clipCount);
+}
+
+const Transform* AnimationClipSet::GetPose(AnimationHandle handle,
+                                           const int frame,
+                                           Transform* scratch) const {
+    if (!m_compressed[handle])
+        return m_clips[handle].framePoses[frame];
+    m_compressed[handle]->Sample((float)frame, scratch);
+    return scratch;
+}
+
+int AnimationClipSet::GetMaxBoneCount() const {
+    int bones = 0;
+    for (int i = 0; i < m_clipCount; i++) {
+        bones = std::max(bones, m_clips[i].boneCount);
+    }
+    return bones;
+}
+
+AnimationHandle AnimationClipSet::FindClip(const char* name) const {
+    for (int i = 0; i < m_clipCount; i++) {
+        if (strcmp(m_clips[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return INVALID_ANIMATION;  // Animation not found
+}
+
+std::shared_ptr<const AnimationClipSet> AnimationLibrary::Acquire(
+    const std::string& path, const ClipCompressionOptions& compression) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const ClipSetKey key = {path, compression};
+    auto it = clipSets.find(key);
+    if (it != clipSets.end()) {
+        std::shared_ptr<const AnimationClipSet> clipSet = it->second.lock();
+        if (clipSet)
+            return clipSet;
+    }
+
+    int clipCount = 0;
+    ModelAnimation* clips = LoadModelAnimations(path.c_str(), &clipCount);
+    if (clips == nullptr || clipCount == 0) {
+        LOG_ERROR("Failed to load animations from: ", path);
+        return nullptr;
+    }
+
+    std::shared_ptr<const AnimationClipSet> clipSet =
+        std::make_shared<AnimationClipSet>(path, clips, clipCount,
+                                           compression);
+    clipSets[key] = clipSet;
+    LOG_INFO("Loaded ", clipCount, " animation clips from ", path, " (",
+             clipSet->GetMemoryBytes(), " bytes)");
+    return clipSet;
+}
+
+std::shared_ptr<const PoseCache> AnimationLibrary::AcquirePoses(
+    const AnimationClipSet& clips, const Model& model,
+    const PoseBakeOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (model.boneCount == 0 || model.bindPose == nullptr) {
+        LOG_ERROR("Cannot bake poses without a skeleton: ", clips.GetPath());
+        return nullptr;
+    }
+
+    const PoseCacheKey key = {{clips.GetPath(), clips.GetCompression()},
+                              options.samplesPerFrame,
+                              options.quantize,
+                              model.boneCount,
+                              hashBindPose(model)};
+    auto it = poseCaches.find(key);
+    if (it != poseCaches.end()) {
+        std::shared_ptr<const PoseCache> poses = it->second.lock();
+        if (poses)
+            return poses;
+    }
+
+    std::shared_ptr<const PoseCache> poses =
+        std::make_shared<PoseCache>(model, clips, options);
+    poseCaches[key] = poses;
+    return poses;
+}
+
+int AnimationLibrary::GetLoadedAssetCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    int count = 0;
+    for (const auto& entry : clipSets) {
+        if (!entry.second.expired())
+            count++;
+    }
+    return count;
+}
+
+size_t AnimationLibrary::GetLoadedBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for (const auto& entry : clipSets) {
+        std::shared_ptr<const AnimationClipSet> clipSet = entry.second.lock();
+        if (clipSet)
+            bytes += clipSet->GetMemoryBytes();
+    }
+    return bytes;
+}
+
+size_t AnimationLibrary::GetBakedBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for (const auto& entry : poseCaches) {
+        std::shared_ptr<const PoseCache> poses = entry.second.lock();
+        if (poses)
+            bytes += poses->GetMemoryBytes();
+    }
+    return bytes;
+}
+
+}  // namespace arena
@@ -0,0 +1,152 @@
+#include "animation_lod.h"
+#include <algorithm>
+#include "raymath.h"
+
+namespace arena {
+
+AnimationLodSystem::AnimationLodSystem(const AnimationLodSettings& settings)
+    : m_settings(settings) {}
+
+int AnimationLodSystem::AddCharacter(const Vector3& position) {
+    int id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = (int)m_characters.size();
+        m_characters.emplace_back();
+    }
+
+    Character& character = m_characters[id];
+    character = Character();
+    character.position = position;
+    character.active = true;
+    return id;
+}
+
+void AnimationLodSystem::RemoveCharacter(const int id) {
+    if (id < 0 || id >= (int)m_characters.size() || !m_characters[id].active)
+        return;
+    m_characters[id].active = false;
+    m_characters[id].update = false;
+    m_freeIds.push_back(id);
+}
+
+void AnimationLodSystem::SetPosition(const int id, const Vector3& position) {
+    m_characters[id].position = position;
+}
+
+AnimationLodTier AnimationLodSystem::classify(const Character& character,
+                                              const float distance) const {
+    // Hysteresis keeps characters near a boundary from flickering between
+    // tiers, only leave the current tier once clearly past the boundary
+    const float boundaries[ANIMATION_LOD_TIERS - 1] = {
+        m_settings.nearDistance, m_settings.midDistance};
+    const int current = (int)character.tier;
+    int tier = 0;
+    for (int i = 0; i < ANIMATION_LOD_TIERS - 1; i++) {
+        float boundary = boundaries[i];
+        if (character.posed) {
+            boundary += i < current ? -m_settings.hysteresis
+                                    : m_settings.hysteresis;
+        }
+        if (distance > boundary)
+            tier = i + 1;
+    }
+    return (AnimationLodTier)tier;
+}
+
+int AnimationLodSystem::updateInterval(const AnimationLodTier tier) const {
+    switch (tier) {
+        case AnimationLodTier::Near:
+            return 1;
+        case AnimationLodTier::Mid:
+            return std::max(m_settings.midUpdateInterval, 1);
+        default:
+            return m_settings.farUpdateInterval;
+    }
+}
+
+int AnimationLodSystem::skinBudget(const AnimationLodTier tier) const {
+    switch (tier) {
+        case AnimationLodTier::Near:
+            return m_settings.nearSkinBudget;
+        case AnimationLodTier::Mid:
+            return m_settings.midSkinBudget;
+        default:
+            return m_settings.farSkinBudget;
+    }
+}
+
+void AnimationLodSystem::Update(const Vector3& viewPosition) {
+    for (std::vector<int>& due : m_due) {
+        due.clear();
+    }
+
+    for (int id = 0; id < (int)m_characters.size(); id++) {
+        Character& character = m_characters[id];
+        character.update = false;
+        if (!character.active)
+            continue;
+
+        character.tier = classify(
+            character, Vector3Distance(viewPosition, character.position));
+        character.framesSinceUpdate++;
+        m_stats.characters[(int)character.tier]++;
+
+        // An interval of 0 freezes the pose, but everyone is posed once
+        const int interval = updateInterval(character.tier);
+        bool due = !character.posed ||
+                   (interval > 0 && character.framesSinceUpdate >= interval);
+        if (due) {
+            m_due[(int)character.tier].push_back(id);
+        } else {
+            m_stats.throttled++;
+        }
+    }
+
+    // Spend each tier's budget on its most stale characters first, so
+    // deferred characters are guaranteed a turn
+    for (int tier = 0; tier < ANIMATION_LOD_TIERS; tier++) {
+        std::vector<int>& due = m_due[tier];
+        const int budget =
+            std::min(skinBudget((AnimationLodTier)tier), (int)due.size());
+        if (budget < (int)due.size()) {
+            std::partial_sort(due.begin(), due.begin() + budget, due.end(),
+                              [this](const int a, const int b) {
+                                  return m_characters[a].framesSinceUpdate >
+                                         m_characters[b].framesSinceUpdate;
+                              });
+        }
+
+        for (int i = 0; i < budget; i++) {
+            Character& character = m_characters[due[i]];
+            character.update = true;
+            character.posed = true;
+            character.framesSinceUpdate = 0;
+        }
+        m_stats.updated += budget;
+        m_stats.deferred += (int)due.size() - budget;
+    }
+
+    m_stats.savedTimeMs =
+        m_averageUpdateMs * (m_stats.throttled + m_stats.deferred);
+}
+
+void AnimationLodSystem::RecordUpdate(const float milliseconds) {
+    m_stats.updateTimeMs += milliseconds;
+
+    // Running average of a full update, used to estimate the time saved
+    const float smoothing = 0.05f;
+    if (m_averageUpdateMs == 0.0f) {
+        m_averageUpdateMs = milliseconds;
+    } else {
+        m_averageUpdateMs += (milliseconds - m_averageUpdateMs) * smoothing;
+    }
+}
+
+void AnimationLodSystem::ResetFrameStats() {
+    m_stats = AnimationLodStats();
+}
+
+}  // namespace arena
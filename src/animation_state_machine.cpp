@@ -0,0 +1,88 @@
+#include "animation_state_machine.h"
+#include <cstring>
+#include "logger.h"
+
+namespace arena {
+
+bool AnimationStateMachine::Compile(
+    const std::vector<AnimationStateDesc>& states,
+    const std::vector<AnimationTransitionDesc>& transitions,
+    const AnimationManager& animations, const char* initialState) {
+    auto findState = [&states](const char* name) {
+        for (size_t i = 0; i < states.size(); i++) {
+            if (strcmp(states[i].name, name) == 0)
+                return (int)i;
+        }
+        return -1;
+    };
+
+    // Resolve clips once, name lookups never happen per frame
+    m_clips.clear();
+    for (const AnimationStateDesc& state : states) {
+        AnimationHandle clip = animations.FindAnimationByName(state.clip);
+        if (clip == INVALID_ANIMATION) {
+            LOG_ERROR("Animation state '", state.name,
+                      "' references missing clip: ", state.clip);
+            return false;
+        }
+        m_clips.push_back(clip);
+    }
+
+    // Resolve transition endpoints
+    struct Resolved {
+        int from;
+        int to;
+        unsigned int required;
+        unsigned int blocked;
+    };
+    std::vector<Resolved> resolved;
+    for (const AnimationTransitionDesc& transition : transitions) {
+        int from = transition.from ? findState(transition.from) : -1;
+        int to = findState(transition.to);
+        if ((transition.from && from == -1) || to == -1) {
+            LOG_ERROR("Invalid animation transition to: ", transition.to);
+            return false;
+        }
+        resolved.push_back({from, to, transition.requiredConditions,
+                            transition.blockedConditions});
+    }
+
+    // Precompute the target state for every state and condition mask
+    m_next.assign(states.size() * CONDITION_MASKS, 0);
+    for (int state = 0; state < (int)states.size(); state++) {
+        for (int mask = 0; mask < CONDITION_MASKS; mask++) {
+            int target = state;
+            bool found = false;
+            for (int pass = 0; pass < 2 && !found; pass++) {
+                for (const Resolved& transition : resolved) {
+                    bool matchesSource = pass == 0 ? transition.from == state
+                                                   : transition.from == -1;
+                    if (matchesSource &&
+                        (mask & transition.required) == transition.required &&
+                        (mask & transition.blocked) == 0) {
+                        target = transition.to;
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            m_next[state * CONDITION_MASKS + mask] = target;
+        }
+    }
+
+    m_currentState = findState(initialState);
+    if (m_currentState == -1) {
+        LOG_ERROR("Initial animation state not found: ", initialState);
+        m_currentState = 0;
+    }
+    return true;
+}
+
+AnimationHandle AnimationStateMachine::Update(unsigned int conditions) {
+    m_currentState =
+        m_next[m_currentState * CONDITION_MASKS +
+               (conditions & (CONDITION_MASKS - 1))];
+    return m_clips[m_currentState];
+}
+
+}  // namespace arena
@@ -0,0 +1,72 @@
+#include "animation_system.h"
+#include <algorithm>
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+AnimationSystem::AnimationSystem(const AnimationSystemSettings& settings,
+                                 JobSystem& jobs)
+    : m_settings(settings), m_jobs(jobs) {}
+
+void AnimationSystem::Add(AnimationManager* animation) {
+    m_instances.push_back(animation);
+}
+
+void AnimationSystem::Remove(AnimationManager* animation) {
+    m_instances.erase(
+        std::remove(m_instances.begin(), m_instances.end(), animation),
+        m_instances.end());
+}
+
+double AnimationSystem::animate(const float deltaTime, const int maxThreads) {
+    utils::Stopwatch timer;
+    m_jobs.ParallelFor(
+        (int)m_instances.size(), m_settings.batchSize,
+        [this, deltaTime](const int begin, const int end) {
+            for (int i = begin; i < end; i++) {
+                m_instances[i]->Animate(deltaTime);
+            }
+        },
+        maxThreads);
+    return timer.ElapsedMs();
+}
+
+void AnimationSystem::Animate(const float deltaTime) {
+    m_stats.instances = (int)m_instances.size();
+    m_stats.threads = std::min(m_jobs.GetThreadCount(),
+                               std::max(1, (int)m_instances.size()));
+    m_stats.animateTimeMs = (float)animate(deltaTime, 0);
+}
+
+void AnimationSystem::Upload() {
+    // GL calls are only valid on the main thread
+    utils::Stopwatch timer;
+    for (AnimationManager* animation : m_instances) {
+        animation->Upload();
+    }
+    m_stats.uploadTimeMs = timer.ElapsedMs();
+}
+
+void AnimationSystem::MeasureScaling() {
+    if (m_instances.empty())
+        return;
+
+    // A zero time step poses and skins without moving playback on
+    const int iterations = std::max(m_settings.scalingIterations, 1);
+    double baseline = 0.0;
+    for (int threads = 1; threads <= m_jobs.GetThreadCount(); threads++) {
+        double total = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            total += animate(0.0f, threads);
+        }
+        double average = total / iterations;
+        if (threads == 1)
+            baseline = average;
+        LOG_INFO("Animation scaling: ", m_instances.size(), " characters on ",
+                 threads, " threads, ", average, " ms (",
+                 average > 0.0 ? baseline / average : 0.0, "x)");
+    }
+}
+
+}  // namespace arena
@@ -0,0 +1,248 @@
+#include "aoi_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+const std::vector<int> AoiGrid::s_empty;
+
+AoiGrid::AoiGrid(const AoiSettings& settings, const TerrainSettings& terrain)
+    : m_settings(settings),
+      m_originX(-terrain.mapWidth / 2),
+      m_originZ(-terrain.mapDepth / 2) {
+    m_cellsX = std::max(1, (int)ceilf(terrain.mapWidth / settings.cellSize));
+    m_cellsZ = std::max(1, (int)ceilf(terrain.mapDepth / settings.cellSize));
+    m_cells.resize(m_cellsX * m_cellsZ);
+    LOG_DEBUG("AOI grid: ", m_cellsX, "x", m_cellsZ, " cells");
+}
+
+bool AoiGrid::isActive(const int entityId) const {
+    return entityId >= 0 && entityId < (int)m_entities.size() &&
+           m_entities[entityId].active;
+}
+
+int AoiGrid::cellIndex(const Vector3& position) const {
+    // Entities outside the arena are clamped into the border cells
+    int x = (int)floorf((position.x - m_originX) / m_settings.cellSize);
+    int z = (int)floorf((position.z - m_originZ) / m_settings.cellSize);
+    x = std::min(std::max(x, 0), m_cellsX - 1);
+    z = std::min(std::max(z, 0), m_cellsZ - 1);
+    return z * m_cellsX + x;
+}
+
+void AoiGrid::linkToCell(const int entityId, const int cell) {
+    Entity& entity = m_entities[entityId];
+    entity.cell = cell;
+    entity.slot = (int)m_cells[cell].size();
+    m_cells[cell].push_back(entityId);
+}
+
+void AoiGrid::unlinkFromCell(const int entityId) {
+    Entity& entity = m_entities[entityId];
+    std::vector<int>& list = m_cells[entity.cell];
+
+    // Swap-remove and patch the slot of the entity that took our place
+    int movedId = list.back();
+    list[entity.slot] = movedId;
+    m_entities[movedId].slot = entity.slot;
+    list.pop_back();
+
+    entity.cell = -1;
+    entity.slot = -1;
+}
+
+int AoiGrid::AddEntity(const Vector3& position) {
+    int entityId;
+    if (!m_freeEntities.empty()) {
+        entityId = m_freeEntities.back();
+        m_freeEntities.pop_back();
+    } else {
+        entityId = (int)m_entities.size();
+        m_entities.push_back(Entity());
+    }
+
+    Entity& entity = m_entities[entityId];
+    entity.position = position;
+    entity.active = true;
+    entity.observer = -1;
+    linkToCell(entityId, cellIndex(position));
+    m_stats.entityCount++;
+    return entityId;
+}
+
+void AoiGrid::RemoveEntity(const int entityId) {
+    if (!isActive(entityId)) {
+        LOG_WARNING("AOI: tried to remove unknown entity ", entityId);
+        return;
+    }
+
+    RemoveObserver(entityId);
+    unlinkFromCell(entityId);
+
+    // Ids are recycled, so observers must forget this one now: a new
+    // entity reusing it then enters their view like any other
+    for (Observer& observer : m_observers) {
+        auto it = std::lower_bound(observer.visible.begin(),
+                                   observer.visible.end(), entityId);
+        if (it != observer.visible.end() && *it == entityId) {
+            observer.visible.erase(it);
+            observer.removed.push_back(entityId);
+        }
+    }
+    m_entities[entityId].active = false;
+    m_freeEntities.push_back(entityId);
+    m_stats.entityCount--;
+}
+
+void AoiGrid::MoveEntity(const int entityId, const Vector3& position) {
+    if (!isActive(entityId)) {
+        LOG_WARNING("AOI: tried to move unknown entity ", entityId);
+        return;
+    }
+    utils::Stopwatch timer;
+    Entity& entity = m_entities[entityId];
+    entity.position = position;
+
+    // Only relink when the entity actually crossed a cell border
+    int cell = cellIndex(position);
+    if (cell != entity.cell) {
+        unlinkFromCell(entityId);
+        linkToCell(entityId, cell);
+        m_stats.cellChanges++;
+    }
+
+    m_stats.moves++;
+    m_stats.moveTimeMs += timer.ElapsedMs();
+}
+
+void AoiGrid::AddObserver(const int entityId, const float radius) {
+    if (!isActive(entityId)) {
+        LOG_WARNING("AOI: tried to observe from unknown entity ", entityId);
+        return;
+    }
+    Entity& entity = m_entities[entityId];
+    if (entity.observer != -1) {
+        m_observers[entity.observer].radius = radius;
+        return;
+    }
+
+    Observer observer;
+    observer.entityId = entityId;
+    observer.radius = radius;
+    entity.observer = (int)m_observers.size();
+    m_observers.push_back(observer);
+    m_stats.observerCount++;
+}
+
+void AoiGrid::RemoveObserver(const int entityId) {
+    if (!isActive(entityId))
+        return;
+    int index = m_entities[entityId].observer;
+    if (index == -1)
+        return;
+
+    // Swap-remove keeping the back observer's entity link valid
+    if (index != (int)m_observers.size() - 1) {
+        std::swap(m_observers[index], m_observers.back());
+        m_entities[m_observers[index].entityId].observer = index;
+    }
+    m_observers.pop_back();
+    m_entities[entityId].observer = -1;
+    m_stats.observerCount--;
+}
+
+void AoiGrid::QueryRadius(const Vector3& center, const float radius,
+                          std::vector<int>& outEntities) const {
+    utils::Stopwatch timer;
+    outEntities.clear();
+
+    Vector3 minCorner = {center.x - radius, 0, center.z - radius};
+    Vector3 maxCorner = {center.x + radius, 0, center.z + radius};
+    int minCell = cellIndex(minCorner);
+    int maxCell = cellIndex(maxCorner);
+    int minX = minCell % m_cellsX, minZ = minCell / m_cellsX;
+    int maxX = maxCell % m_cellsX, maxZ = maxCell / m_cellsX;
+
+    const float radiusSq = radius * radius;
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+            for (int entityId : m_cells[z * m_cellsX + x]) {
+                const Vector3& p = m_entities[entityId].position;
+                float dx = p.x - center.x;
+                float dz = p.z - center.z;
+                m_stats.candidatesTested++;
+                if (dx * dx + dz * dz <= radiusSq) {
+                    outEntities.push_back(entityId);
+                }
+            }
+        }
+    }
+
+    m_stats.queries++;
+    m_stats.queryTimeMs += timer.ElapsedMs();
+}
+
+void AoiGrid::Update() {
+    for (Observer& observer : m_observers) {
+        QueryRadius(m_entities[observer.entityId].position, observer.radius,
+                    m_scratch);
+
+        // Observers never replicate themselves
+        m_scratch.erase(
+            std::remove(m_scratch.begin(), m_scratch.end(), observer.entityId),
+            m_scratch.end());
+        std::sort(m_scratch.begin(), m_scratch.end());
+
+        observer.entered.clear();
+        observer.left.clear();
+        std::set_difference(m_scratch.begin(), m_scratch.end(),
+                            observer.visible.begin(), observer.visible.end(),
+                            std::back_inserter(observer.entered));
+        std::set_difference(observer.visible.begin(), observer.visible.end(),
+                            m_scratch.begin(), m_scratch.end(),
+                            std::back_inserter(observer.left));
+        if (!observer.removed.empty()) {
+            observer.left.insert(observer.left.end(), observer.removed.begin(),
+                                 observer.removed.end());
+            std::sort(observer.left.begin(), observer.left.end());
+            observer.removed.clear();
+        }
+        observer.visible.swap(m_scratch);
+    }
+}
+
+bool AoiGrid::IsRelevant(const int observerId, const int entityId) const {
+    const std::vector<int>& visible = GetVisibleEntities(observerId);
+    return std::binary_search(visible.begin(), visible.end(), entityId);
+}
+
+const std::vector<int>& AoiGrid::GetVisibleEntities(
+    const int observerId) const {
+    int index = m_entities[observerId].observer;
+    return index == -1 ? s_empty : m_observers[index].visible;
+}
+
+const std::vector<int>& AoiGrid::GetEnteredEntities(
+    const int observerId) const {
+    int index = m_entities[observerId].observer;
+    return index == -1 ? s_empty : m_observers[index].entered;
+}
+
+const std::vector<int>& AoiGrid::GetLeftEntities(const int observerId) const {
+    int index = m_entities[observerId].observer;
+    return index == -1 ? s_empty : m_observers[index].left;
+}
+
+void AoiGrid::ResetFrameStats() {
+    m_stats.moves = 0;
+    m_stats.cellChanges = 0;
+    m_stats.queries = 0;
+    m_stats.candidatesTested = 0;
+    m_stats.moveTimeMs = 0.0;
+    m_stats.queryTimeMs = 0.0;
+}
+
+}  // namespace arena
@@ -0,0 +1,111 @@
+#include "asset_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "logger.h"
+#include "raylib.h"
+#include "utils.h"
+
+namespace arena {
+
+std::map<std::string, std::weak_ptr<const AssetBlob>> AssetCache::blobs;
+std::mutex AssetCache::mutex;
+AssetCacheStats AssetCache::stats;
+
+void AssetCache::Install() {
+    SetLoadFileDataCallback(&AssetCache::loadFileData);
+}
+
+bool AssetCache::readFile(const std::string& path,
+                          std::vector<unsigned char>& outData) {
+    utils::Stopwatch timer;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return false;
+    }
+    outData.resize(size);
+    size_t read = fread(outData.data(), 1, outData.size(), file);
+    fclose(file);
+    if (read != outData.size())
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.diskReads++;
+    stats.bytesRead += outData.size();
+    stats.readTimeMs += timer.ElapsedMs();
+    return true;
+}
+
+std::shared_ptr<const AssetBlob> AssetCache::Acquire(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = blobs.find(path);
+        if (it != blobs.end()) {
+            std::shared_ptr<const AssetBlob> blob = it->second.lock();
+            if (blob) {
+                stats.cacheHits++;
+                return blob;
+            }
+        }
+    }
+
+    std::shared_ptr<AssetBlob> blob = std::make_shared<AssetBlob>();
+    blob->path = path;
+    if (!readFile(path, blob->data)) {
+        LOG_ERROR("Failed to read asset: ", path);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    blobs[path] = blob;
+    return blob;
+}
+
+unsigned char* AssetCache::loadFileData(const char* fileName, int* dataSize) {
+    *dataSize = 0;
+
+    // raylib releases the returned buffer with UnloadFileData, so cached
+    // bytes are copied into raylib's allocator instead of re-read
+    std::shared_ptr<const AssetBlob> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = blobs.find(fileName);
+        if (it != blobs.end())
+            cached = it->second.lock();
+        if (cached)
+            stats.cacheHits++;
+    }
+
+    std::vector<unsigned char> data;
+    const std::vector<unsigned char>* source = &data;
+    if (cached) {
+        source = &cached->data;
+    } else if (!readFile(fileName, data)) {
+        LOG_WARNING("Failed to open file: ", fileName);
+        return nullptr;
+    }
+
+    unsigned char* buffer =
+        (unsigned char*)MemAlloc((unsigned int)std::max<size_t>(
+            source->size(), 1));
+    if (buffer == nullptr)
+        return nullptr;
+    if (!source->empty())
+        memcpy(buffer, source->data(), source->size());
+    *dataSize = (int)source->size();
+    return buffer;
+}
+
+AssetCacheStats AssetCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+}  // namespace arena
@@ -0,0 +1,48 @@
+#include "asset_loader.h"
+#include <algorithm>
+
+namespace arena {
+
+AssetLoader::AssetLoader(int threadCount) {
+    threadCount = std::max(threadCount, 1);
+    for (int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void AssetLoader::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void AssetLoader::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_quit || !m_tasks.empty(); });
+        // Finish queued loads before quitting so no future is abandoned
+        if (m_tasks.empty())
+            return;
+
+        std::function<void()> task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+}  // namespace arena
@@ -22,15 +22,21 @@ Camera::Camera(const CameraSettings& settings) : m_settings(settings) {
     m_camera.projection = CAMERA_PERSPECTIVE;
 }
 
+float Camera::SampleInput(const float deltaTime) const {
+    if (!IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+        return 0.0f;
+    return GetMouseDelta().y * m_settings.mouseSensitivity * deltaTime;
+}
+
 void Camera::Update(const Vector3& targetPosition, const Vector3& playerFacing,
-                    const float deltaTime) {
+                    const float pitchDelta) {
     // Update camera
-    UpdateFreeLookCamera(targetPosition, playerFacing, deltaTime);
+    UpdateFreeLookCamera(targetPosition, playerFacing, pitchDelta);
 }
 
 void Camera::UpdateFreeLookCamera(const Vector3& targetPosition,
                                   const Vector3& playerFacing,
-                                  const float deltaTime) {
+                                  const float pitchDelta) {
     static float angleY = 0.0f;
 
     LOG_DEBUG("----------------------------------------------------");
@@ -39,13 +45,8 @@ void Camera::UpdateFreeLookCamera(const Vector3& targetPosition,
     LOG_DEBUG("Start camera target: (", m_camera.target.x, ", ",
               m_camera.target.y, ", ", m_camera.target.z, ")");
 
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-        Vector2 mouseDelta = GetMouseDelta();
-        angleY += mouseDelta.y * m_settings.mouseSensitivity * deltaTime;
-
-        // Clamp vertical angle to avoid camera flip
-        angleY = utils::Clamp(angleY, -89.0f, 89.0f);
-    }
+    // Clamp vertical angle to avoid camera flip
+    angleY = utils::Clamp(angleY + pitchDelta, -89.0f, 89.0f);
 
     LOG_DEBUG("angleY: ", angleY);
     LOG_DEBUG("m_settings.cameraDistance: ", m_settings.cameraDistance);
@@ -0,0 +1,160 @@
+#include "character_collision.h"
+#include <algorithm>
+#include <cmath>
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+CharacterCollisionSystem::CharacterCollisionSystem(
+    const PhysicsSettings& settings)
+    : m_settings(settings) {}
+
+int CharacterCollisionSystem::AddCharacter(const Vector3& position,
+                                           const float radius,
+                                           const float height) {
+    int characterId;
+    if (!m_freeCharacters.empty()) {
+        characterId = m_freeCharacters.back();
+        m_freeCharacters.pop_back();
+    } else {
+        characterId = (int)m_characters.size();
+        m_characters.push_back(Character());
+    }
+
+    Character& character = m_characters[characterId];
+    character.position = position;
+    character.inputPosition = position;
+    character.radius = radius;
+    character.height = height;
+    character.active = true;
+
+    // New entries are appended, the next insertion sort moves them in place
+    m_sweep.push_back({position.x - radius, position.x + radius, characterId});
+    m_stats.characterCount++;
+    return characterId;
+}
+
+void CharacterCollisionSystem::RemoveCharacter(const int characterId) {
+    if (characterId < 0 || characterId >= (int)m_characters.size() ||
+        !m_characters[characterId].active) {
+        return;
+    }
+
+    m_characters[characterId].active = false;
+    m_freeCharacters.push_back(characterId);
+    m_sweep.erase(std::find_if(m_sweep.begin(), m_sweep.end(),
+                               [characterId](const SweepEntry& entry) {
+                                   return entry.characterId == characterId;
+                               }));
+    m_stats.characterCount--;
+}
+
+void CharacterCollisionSystem::SetPosition(const int characterId,
+                                           const Vector3& position) {
+    Character& character = m_characters[characterId];
+    character.position = position;
+    character.inputPosition = position;
+}
+
+Vector3 CharacterCollisionSystem::GetCorrection(const int characterId) const {
+    const Character& character = m_characters[characterId];
+    return Vector3Subtract(character.position, character.inputPosition);
+}
+
+void CharacterCollisionSystem::refreshSweepList() {
+    for (SweepEntry& entry : m_sweep) {
+        const Character& character = m_characters[entry.characterId];
+        entry.minX = character.position.x - character.radius;
+        entry.maxX = character.position.x + character.radius;
+    }
+
+    // Insertion sort, nearly free when the previous order still holds
+    for (size_t i = 1; i < m_sweep.size(); i++) {
+        SweepEntry entry = m_sweep[i];
+        size_t j = i;
+        while (j > 0 && m_sweep[j - 1].minX > entry.minX) {
+            m_sweep[j] = m_sweep[j - 1];
+            j--;
+            m_stats.sortSwaps++;
+        }
+        m_sweep[j] = entry;
+    }
+}
+
+void CharacterCollisionSystem::separate(Character& a, Character& b,
+                                        const int idA, const int idB) {
+    // Cheap rejection on the remaining axes before the capsule test
+    float reach = a.radius + b.radius;
+    if (fabsf(a.position.z - b.position.z) > reach ||
+        fabsf(a.position.y - b.position.y) > (a.height + b.height) / 2) {
+        return;
+    }
+
+    m_stats.pairsTested++;
+
+    float halfA = std::max(a.height / 2 - a.radius, 0.0f);
+    float halfB = std::max(b.height / 2 - b.radius, 0.0f);
+    Vector3 closestA, closestB;
+    utils::ClosestPointsSegmentSegment(
+        Vector3{a.position.x, a.position.y - halfA, a.position.z},
+        Vector3{a.position.x, a.position.y + halfA, a.position.z},
+        Vector3{b.position.x, b.position.y - halfB, b.position.z},
+        Vector3{b.position.x, b.position.y + halfB, b.position.z}, closestA,
+        closestB);
+
+    Vector3 delta = Vector3Subtract(closestB, closestA);
+    float distance = Vector3Length(delta);
+    if (distance >= reach)
+        return;
+
+    m_stats.contacts++;
+
+    // Push apart on the ground plane only, vertical response is left to
+    // the terrain collision
+    Vector3 normal = {delta.x, 0, delta.z};
+    float horizontal = Vector3Length(normal);
+    if (horizontal > 1e-5f) {
+        normal = Vector3Scale(normal, 1.0f / horizontal);
+    } else {
+        // Perfectly stacked characters, pick a stable direction per pair
+        unsigned int hash = ((unsigned int)idA * 73856093u) ^
+                            ((unsigned int)idB * 19349663u);
+        float angle = (float)(hash % 6283u) * 0.001f;
+        normal = Vector3{cosf(angle), 0, sinf(angle)};
+    }
+
+    float push = (reach - distance) * 0.5f;
+    a.position = Vector3Subtract(a.position, Vector3Scale(normal, push));
+    b.position = Vector3Add(b.position, Vector3Scale(normal, push));
+}
+
+void CharacterCollisionSystem::Resolve() {
+    utils::Stopwatch timer;
+    m_stats.sortSwaps = 0;
+    m_stats.pairsTested = 0;
+    m_stats.contacts = 0;
+
+    for (int iteration = 0;
+         iteration < m_settings.characterSeparationIterations; iteration++) {
+        refreshSweepList();
+
+        int contactsBefore = m_stats.contacts;
+        for (size_t i = 0; i < m_sweep.size(); i++) {
+            const float maxX = m_sweep[i].maxX;
+            for (size_t j = i + 1;
+                 j < m_sweep.size() && m_sweep[j].minX <= maxX; j++) {
+                int idA = m_sweep[i].characterId;
+                int idB = m_sweep[j].characterId;
+                separate(m_characters[idA], m_characters[idB], idA, idB);
+            }
+        }
+
+        if (m_stats.contacts == contactsBefore)
+            break;
+    }
+
+    m_stats.resolveTimeMs = timer.ElapsedMs();
+}
+
+}  // namespace arena
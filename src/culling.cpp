@@ -0,0 +1,380 @@
+#include "culling.h"
+#include "occlusion.h"
+#include <algorithm>
+#include <cmath>
+#include "raymath.h"
+#include "rlgl.h"
+#include "utils.h"
+
+// ARENA_CULLING_NO_SSE forces the scalar path, the tests build both
+#if !defined(ARENA_CULLING_NO_SSE) && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ARENA_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace arena {
+
+static const int GROUP_SIZE = 4;
+
+static int roundUpToGroup(const int count) {
+    return (count + GROUP_SIZE - 1) / GROUP_SIZE * GROUP_SIZE;
+}
+
+// Normalized plane a * row + sign * b of the combined matrix
+static Vector4 combinePlane(const Vector4& a, const Vector4& b,
+                            const float sign) {
+    Vector4 plane = {a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z,
+                     a.w + sign * b.w};
+    float length =
+        sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    if (length > 0.0f) {
+        plane.x /= length;
+        plane.y /= length;
+        plane.z /= length;
+        plane.w /= length;
+    }
+    return plane;
+}
+
+Frustum Frustum::FromMatrix(const Matrix& m) {
+    // Rows of the combined matrix as it applies to column vectors
+    const Vector4 x = {m.m0, m.m4, m.m8, m.m12};
+    const Vector4 y = {m.m1, m.m5, m.m9, m.m13};
+    const Vector4 z = {m.m2, m.m6, m.m10, m.m14};
+    const Vector4 w = {m.m3, m.m7, m.m11, m.m15};
+
+    Frustum frustum;
+    frustum.planes[0] = combinePlane(w, x, 1.0f);   // Left
+    frustum.planes[1] = combinePlane(w, x, -1.0f);  // Right
+    frustum.planes[2] = combinePlane(w, y, 1.0f);   // Bottom
+    frustum.planes[3] = combinePlane(w, y, -1.0f);  // Top
+    frustum.planes[4] = combinePlane(w, z, 1.0f);   // Near
+    frustum.planes[5] = combinePlane(w, z, -1.0f);  // Far
+    return frustum;
+}
+
+Matrix GetCameraViewProjection(const Camera3D& camera, const float aspect) {
+    Matrix projection;
+    if (camera.projection == CAMERA_ORTHOGRAPHIC) {
+        double top = camera.fovy / 2.0;
+        double right = top * aspect;
+        projection = MatrixOrtho(-right, right, -top, top,
+                                 RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    } else {
+        projection =
+            MatrixPerspective(camera.fovy * DEG2RAD, aspect,
+                              RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    return MatrixMultiply(view, projection);
+}
+
+Frustum Frustum::FromCamera(const Camera3D& camera, const float aspect) {
+    return FromMatrix(GetCameraViewProjection(camera, aspect));
+}
+
+void CullingSystem::PackedBounds::Resize(const int count) {
+    const int size = roundUpToGroup(count);
+    minX.resize(size, 0.0f);
+    minY.resize(size, 0.0f);
+    minZ.resize(size, 0.0f);
+    maxX.resize(size, 0.0f);
+    maxY.resize(size, 0.0f);
+    maxZ.resize(size, 0.0f);
+}
+
+void CullingSystem::PackedBounds::Set(const int index, const BoundingBox& box) {
+    minX[index] = box.min.x;
+    minY[index] = box.min.y;
+    minZ[index] = box.min.z;
+    maxX[index] = box.max.x;
+    maxY[index] = box.max.y;
+    maxZ[index] = box.max.z;
+}
+
+int CullingSystem::AddObject(const std::vector<BoundingBox>& meshBounds) {
+    const int meshCount = (int)meshBounds.size();
+
+    // Reuse a freed id whose mesh slots are large enough
+    int id = -1;
+    for (size_t i = 0; i < m_freeIds.size(); i++) {
+        if (m_objects[m_freeIds[i]].meshCapacity >= meshCount) {
+            id = m_freeIds[i];
+            m_freeIds.erase(m_freeIds.begin() + i);
+            break;
+        }
+    }
+    if (id < 0) {
+        id = (int)m_objects.size();
+        m_objects.emplace_back();
+        m_objects[id].firstMesh = (int)m_meshVisible.size();
+        m_objects[id].meshCapacity = meshCount;
+        m_meshVisible.resize(m_meshVisible.size() + meshCount, 0);
+        m_meshBounds.Resize((int)m_meshVisible.size());
+        m_objectBounds.Resize((int)m_objects.size());
+        m_positionX.resize(m_objectBounds.Size(), 0.0f);
+        m_positionY.resize(m_objectBounds.Size(), 0.0f);
+        m_positionZ.resize(m_objectBounds.Size(), 0.0f);
+    }
+
+    Object& object = m_objects[id];
+    object.meshCount = meshCount;
+    object.active = true;
+    object.visible = false;
+
+    BoundingBox objectBounds = {Vector3Zero(), Vector3Zero()};
+    for (int i = 0; i < meshCount; i++) {
+        m_meshBounds.Set(object.firstMesh + i, meshBounds[i]);
+        if (i == 0) {
+            objectBounds = meshBounds[i];
+        } else {
+            objectBounds.min = Vector3Min(objectBounds.min, meshBounds[i].min);
+            objectBounds.max = Vector3Max(objectBounds.max, meshBounds[i].max);
+        }
+    }
+    m_objectBounds.Set(id, objectBounds);
+    SetPosition(id, Vector3Zero());
+    return id;
+}
+
+void CullingSystem::RemoveObject(const int id) {
+    if (id < 0 || id >= (int)m_objects.size() || !m_objects[id].active)
+        return;
+    m_objects[id].active = false;
+    m_objects[id].visible = false;
+    m_freeIds.push_back(id);
+}
+
+void CullingSystem::SetPosition(const int id, const Vector3& position) {
+    if (id < 0 || id >= (int)m_objects.size())
+        return;
+    m_positionX[id] = position.x;
+    m_positionY[id] = position.y;
+    m_positionZ[id] = position.z;
+}
+
+void CullingSystem::translate(const PackedBounds& bounds, const int first,
+                              const int count, const float* offsetX,
+                              const float* offsetY, const float* offsetZ,
+                              const int offsetStride, PackedBounds& world) {
+    world.Resize(count);
+    for (int i = 0; i < count; i++) {
+        const int offset = i * offsetStride;
+        world.minX[i] = bounds.minX[first + i] + offsetX[offset];
+        world.minY[i] = bounds.minY[first + i] + offsetY[offset];
+        world.minZ[i] = bounds.minZ[first + i] + offsetZ[offset];
+        world.maxX[i] = bounds.maxX[first + i] + offsetX[offset];
+        world.maxY[i] = bounds.maxY[first + i] + offsetY[offset];
+        world.maxZ[i] = bounds.maxZ[first + i] + offsetZ[offset];
+    }
+}
+
+void CullingSystem::classify(const Frustum& frustum, const PackedBounds& world,
+                             const int count, BoxResults& results) {
+    // A box is outside when its corner farthest along a plane normal is
+    // behind the plane, and straddles when its nearest corner is
+    const int size = roundUpToGroup(count);
+    results.outside.resize(size);
+    results.straddling.resize(size);
+    m_stats.boxesTested += count;
+
+#ifdef ARENA_CULLING_SSE
+    const __m128 zero = _mm_setzero_ps();
+    for (int i = 0; i < size; i += GROUP_SIZE) {
+        const __m128 minX = _mm_loadu_ps(&world.minX[i]);
+        const __m128 minY = _mm_loadu_ps(&world.minY[i]);
+        const __m128 minZ = _mm_loadu_ps(&world.minZ[i]);
+        const __m128 maxX = _mm_loadu_ps(&world.maxX[i]);
+        const __m128 maxY = _mm_loadu_ps(&world.maxY[i]);
+        const __m128 maxZ = _mm_loadu_ps(&world.maxZ[i]);
+        __m128 outside = zero;
+        __m128 straddling = zero;
+        for (const Vector4& plane : frustum.planes) {
+            const __m128 a = _mm_set1_ps(plane.x);
+            const __m128 b = _mm_set1_ps(plane.y);
+            const __m128 c = _mm_set1_ps(plane.z);
+            const __m128 d = _mm_set1_ps(plane.w);
+            const __m128 farDistance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a, plane.x >= 0.0f ? maxX : minX),
+                           _mm_mul_ps(b, plane.y >= 0.0f ? maxY : minY)),
+                _mm_add_ps(_mm_mul_ps(c, plane.z >= 0.0f ? maxZ : minZ), d));
+            const __m128 nearDistance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a, plane.x >= 0.0f ? minX : maxX),
+                           _mm_mul_ps(b, plane.y >= 0.0f ? minY : maxY)),
+                _mm_add_ps(_mm_mul_ps(c, plane.z >= 0.0f ? minZ : maxZ), d));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(farDistance, zero));
+            straddling =
+                _mm_or_ps(straddling, _mm_cmplt_ps(nearDistance, zero));
+        }
+        const int outsideMask = _mm_movemask_ps(outside);
+        const int straddlingMask = _mm_movemask_ps(straddling);
+        for (int lane = 0; lane < GROUP_SIZE; lane++) {
+            results.outside[i + lane] = (outsideMask >> lane) & 1;
+            results.straddling[i + lane] = (straddlingMask >> lane) & 1;
+        }
+    }
+#else
+    for (int i = 0; i < size; i++) {
+        const float minX = world.minX[i], minY = world.minY[i];
+        const float minZ = world.minZ[i], maxX = world.maxX[i];
+        const float maxY = world.maxY[i], maxZ = world.maxZ[i];
+        bool outside = false;
+        bool straddling = false;
+        for (const Vector4& plane : frustum.planes) {
+            float farDistance = plane.x * (plane.x >= 0.0f ? maxX : minX) +
+                                plane.y * (plane.y >= 0.0f ? maxY : minY) +
+                                plane.z * (plane.z >= 0.0f ? maxZ : minZ) +
+                                plane.w;
+            float nearDistance = plane.x * (plane.x >= 0.0f ? minX : maxX) +
+                                 plane.y * (plane.y >= 0.0f ? minY : maxY) +
+                                 plane.z * (plane.z >= 0.0f ? minZ : maxZ) +
+                                 plane.w;
+            outside |= farDistance < 0.0f;
+            straddling |= nearDistance < 0.0f;
+        }
+        results.outside[i] = outside;
+        results.straddling[i] = straddling;
+    }
+#endif
+}
+
+bool CullingSystem::cullMeshes(const Frustum& frustum, const int id) {
+    const Object& object = m_objects[id];
+    translate(m_meshBounds, object.firstMesh, object.meshCount,
+              &m_positionX[id], &m_positionY[id], &m_positionZ[id], 0,
+              m_meshWorld);
+    classify(frustum, m_meshWorld, object.meshCount, m_meshResults);
+
+    bool visible = false;
+    for (int i = 0; i < object.meshCount; i++) {
+        bool meshVisible = !m_meshResults.outside[i];
+        m_meshVisible[object.firstMesh + i] = meshVisible;
+        visible |= meshVisible;
+    }
+    return visible;
+}
+
+void CullingSystem::Cull(const Frustum& frustum) {
+    utils::Stopwatch timer;
+    m_stats = CullingStats();
+    m_visible.clear();
+
+    const int objectCount = (int)m_objects.size();
+    translate(m_objectBounds, 0, objectCount, m_positionX.data(),
+              m_positionY.data(), m_positionZ.data(), 1, m_objectWorld);
+    classify(frustum, m_objectWorld, objectCount, m_objectResults);
+
+    for (int id = 0; id < objectCount; id++) {
+        Object& object = m_objects[id];
+        if (!object.active)
+            continue;
+
+        // Only objects crossing a plane need their meshes tested
+        const bool outside = m_objectResults.outside[id];
+        const bool straddling = m_objectResults.straddling[id];
+        if (!outside && straddling && object.meshCount > 1) {
+            object.visible = cullMeshes(frustum, id);
+        } else {
+            object.visible = !outside;
+            std::fill_n(m_meshVisible.begin() + object.firstMesh,
+                        object.meshCount, object.visible ? 1 : 0);
+        }
+
+        m_stats.objects++;
+        m_stats.meshes += object.meshCount;
+        if (object.visible) {
+            m_visible.push_back(id);
+            m_stats.visibleObjects++;
+            m_stats.visibleMeshes += (int)std::count(
+                m_meshVisible.begin() + object.firstMesh,
+                m_meshVisible.begin() + object.firstMesh + object.meshCount,
+                1);
+        }
+    }
+    m_stats.culledObjects = m_stats.objects - m_stats.visibleObjects;
+    m_stats.culledMeshes = m_stats.meshes - m_stats.visibleMeshes;
+    m_stats.cullTimeMs = timer.ElapsedMs();
+}
+
+BoundingBox CullingSystem::getWorldBounds(const PackedBounds& bounds,
+                                          const int index,
+                                          const int id) const {
+    const Vector3 position = {m_positionX[id], m_positionY[id],
+                              m_positionZ[id]};
+    return BoundingBox{
+        Vector3Add(Vector3{bounds.minX[index], bounds.minY[index],
+                           bounds.minZ[index]},
+                   position),
+        Vector3Add(Vector3{bounds.maxX[index], bounds.maxY[index],
+                           bounds.maxZ[index]},
+                   position)};
+}
+
+void CullingSystem::ApplyOcclusion(OcclusionCuller& occlusion) {
+    utils::Stopwatch timer;
+    size_t kept = 0;
+    for (const int id : m_visible) {
+        Object& object = m_objects[id];
+        if (!occlusion.IsVisible(getWorldBounds(m_objectBounds, id, id))) {
+            object.visible = false;
+            m_stats.occludedObjects++;
+        } else if (object.meshCount > 1) {
+            // A visible object can still have hidden meshes
+            bool anyVisible = false;
+            for (int i = 0; i < object.meshCount; i++) {
+                const int mesh = object.firstMesh + i;
+                if (m_meshVisible[mesh] &&
+                    !occlusion.IsVisible(
+                        getWorldBounds(m_meshBounds, mesh, id))) {
+                    m_meshVisible[mesh] = 0;
+                    m_stats.occludedMeshes++;
+                }
+                anyVisible |= m_meshVisible[mesh] != 0;
+            }
+            object.visible = anyVisible;
+            if (!anyVisible)
+                m_stats.occludedObjects++;
+        }
+
+        if (object.visible) {
+            m_visible[kept++] = id;
+        } else {
+            int hidden = (int)std::count(
+                m_meshVisible.begin() + object.firstMesh,
+                m_meshVisible.begin() + object.firstMesh + object.meshCount,
+                1);
+            m_stats.occludedMeshes += hidden;
+            std::fill_n(m_meshVisible.begin() + object.firstMesh,
+                        object.meshCount, 0);
+        }
+    }
+    m_visible.resize(kept);
+
+    m_stats.visibleObjects = (int)m_visible.size();
+    m_stats.visibleMeshes = 0;
+    for (const int id : m_visible) {
+        const Object& object = m_objects[id];
+        m_stats.visibleMeshes += (int)std::count(
+            m_meshVisible.begin() + object.firstMesh,
+            m_meshVisible.begin() + object.firstMesh + object.meshCount, 1);
+    }
+    m_stats.culledObjects = m_stats.objects - m_stats.visibleObjects;
+    m_stats.culledMeshes = m_stats.meshes - m_stats.visibleMeshes;
+    m_stats.cullTimeMs += timer.ElapsedMs();
+}
+
+bool CullingSystem::IsVisible(const int id) const {
+    if (id < 0 || id >= (int)m_objects.size())
+        return false;
+    return m_objects[id].active && m_objects[id].visible;
+}
+
+bool CullingSystem::IsMeshVisible(const int id, const int mesh) const {
+    if (!IsVisible(id) || mesh < 0 || mesh >= m_objects[id].meshCount)
+        return false;
+    return m_meshVisible[m_objects[id].firstMesh + mesh] != 0;
+}
+
+}  // namespace arena
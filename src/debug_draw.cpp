@@ -0,0 +1,193 @@
+#include "debug_draw.h"
+
+#ifdef ARENA_DEBUG_DRAW
+
+#include "raymath.h"
+#include "rlgl.h"
+
+namespace arena {
+
+// Segments per sphere ring
+static const int DEBUG_SPHERE_SEGMENTS = 16;
+
+std::atomic<unsigned int> DebugDraw::enabled(DEBUG_DRAW_ALL);
+std::mutex DebugDraw::mutex;
+DebugDraw::Frame DebugDraw::frames[2];
+int DebugDraw::queued = 0;
+
+void DebugDraw::Frame::Clear() {
+    lines.clear();
+    triangles.clear();
+    labels.clear();
+}
+
+void DebugDraw::SetEnabled(const unsigned int categories, const bool show) {
+    if (show) {
+        enabled.fetch_or(categories);
+    } else {
+        enabled.fetch_and(~categories);
+    }
+}
+
+void DebugDraw::Toggle(const unsigned int categories) {
+    enabled.fetch_xor(categories);
+}
+
+bool DebugDraw::IsEnabled(const unsigned int categories) {
+    return (enabled.load() & categories) != 0;
+}
+
+void DebugDraw::Line(const unsigned int category, const Vector3& start,
+                     const Vector3& end, const Color color) {
+    if (!IsEnabled(category))
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Vertex>& lines = frames[queued].lines;
+    lines.push_back(Vertex{start, color});
+    lines.push_back(Vertex{end, color});
+}
+
+void DebugDraw::Triangle(const unsigned int category, const Vector3& v1,
+                         const Vector3& v2, const Vector3& v3,
+                         const Color color) {
+    if (!IsEnabled(category))
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Vertex>& triangles = frames[queued].triangles;
+    triangles.push_back(Vertex{v1, color});
+    triangles.push_back(Vertex{v2, color});
+    triangles.push_back(Vertex{v3, color});
+}
+
+void DebugDraw::addCircle(const Vector3& center, const Vector3& axisU,
+                          const Vector3& axisV, const float radius,
+                          const Color color, std::vector<Vertex>& lines) {
+    Vector3 previous = Vector3Add(center, Vector3Scale(axisU, radius));
+    for (int i = 1; i <= DEBUG_SPHERE_SEGMENTS; i++) {
+        const float angle = 2.0f * PI * i / DEBUG_SPHERE_SEGMENTS;
+        const Vector3 point = Vector3Add(
+            center, Vector3Add(Vector3Scale(axisU, cosf(angle) * radius),
+                               Vector3Scale(axisV, sinf(angle) * radius)));
+        lines.push_back(Vertex{previous, color});
+        lines.push_back(Vertex{point, color});
+        previous = point;
+    }
+}
+
+void DebugDraw::Sphere(const unsigned int category, const Vector3& center,
+                       const float radius, const Color color) {
+    if (!IsEnabled(category))
+        return;
+    // One ring around each axis
+    const Vector3 x = {1.0f, 0.0f, 0.0f};
+    const Vector3 y = {0.0f, 1.0f, 0.0f};
+    const Vector3 z = {0.0f, 0.0f, 1.0f};
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Vertex>& lines = frames[queued].lines;
+    addCircle(center, x, y, radius, color, lines);
+    addCircle(center, y, z, radius, color, lines);
+    addCircle(center, z, x, radius, color, lines);
+}
+
+void DebugDraw::Box(const unsigned int category, const Vector3& center,
+                    const Vector3& size, const Color color) {
+    if (!IsEnabled(category))
+        return;
+    const Vector3 half = Vector3Scale(size, 0.5f);
+    Vector3 corners[8];
+    for (int i = 0; i < 8; i++) {
+        corners[i] = Vector3{center.x + (i & 1 ? half.x : -half.x),
+                             center.y + (i & 2 ? half.y : -half.y),
+                             center.z + (i & 4 ? half.z : -half.z)};
+    }
+    // Corners differing in exactly one bit share an edge
+    static const int EDGES[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7},
+                                     {0, 2}, {1, 3}, {4, 6}, {5, 7},
+                                     {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Vertex>& lines = frames[queued].lines;
+    for (const auto& edge : EDGES) {
+        lines.push_back(Vertex{corners[edge[0]], color});
+        lines.push_back(Vertex{corners[edge[1]], color});
+    }
+}
+
+void DebugDraw::Text(const unsigned int category, const Vector3& position,
+                     const char* text, const Color color) {
+    if (!IsEnabled(category))
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    frames[queued].labels.push_back(Label{position, text, color});
+}
+
+void DebugDraw::Swap() {
+    std::lock_guard<std::mutex> lock(mutex);
+    queued = 1 - queued;
+    frames[queued].Clear();
+}
+
+int DebugDraw::Flush() {
+    int drawn;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drawn = 1 - queued;
+    }
+    const Frame& frame = frames[drawn];
+
+    // rlgl keeps consecutive vertices of one primitive type in a single
+    // draw, so each list goes out as one batch
+    int batches = 0;
+    if (!frame.lines.empty()) {
+        rlBegin(RL_LINES);
+        for (const Vertex& vertex : frame.lines) {
+            rlColor4ub(vertex.color.r, vertex.color.g, vertex.color.b,
+                       vertex.color.a);
+            rlVertex3f(vertex.position.x, vertex.position.y,
+                       vertex.position.z);
+        }
+        rlEnd();
+        batches++;
+    }
+    if (!frame.triangles.empty()) {
+        rlBegin(RL_TRIANGLES);
+        for (const Vertex& vertex : frame.triangles) {
+            rlColor4ub(vertex.color.r, vertex.color.g, vertex.color.b,
+                       vertex.color.a);
+            rlVertex3f(vertex.position.x, vertex.position.y,
+                       vertex.position.z);
+        }
+        rlEnd();
+        batches++;
+    }
+    return batches;
+}
+
+int DebugDraw::FlushText(const Camera3D& camera) {
+    int drawn;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drawn = 1 - queued;
+    }
+    const Frame& frame = frames[drawn];
+    if (frame.labels.empty())
+        return 0;
+
+    const int fontSize = 20;
+    const Vector3 forward = Vector3Subtract(camera.target, camera.position);
+    for (const Label& label : frame.labels) {
+        // Points behind the camera project back onto the screen
+        if (Vector3DotProduct(Vector3Subtract(label.position,
+                                              camera.position),
+                              forward) <= 0.0f)
+            continue;
+        const Vector2 screen = GetWorldToScreen(label.position, camera);
+        const int width = MeasureText(label.text.c_str(), fontSize);
+        DrawText(label.text.c_str(), (int)screen.x - width / 2,
+                 (int)screen.y - fontSize / 2, fontSize, label.color);
+    }
+    return 1;
+}
+
+}  // namespace arena
+
+#endif  // ARENA_DEBUG_DRAW
@@ -0,0 +1,90 @@
+#include "frame_pipeline.h"
+#include <algorithm>
+
+namespace arena {
+
+static float toMs(const std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+FramePipeline::FramePipeline(const bool threaded) {
+    if (threaded)
+        m_thread = std::thread(&FramePipeline::threadLoop, this);
+}
+
+FramePipeline::~FramePipeline() {
+    Wait();
+    if (!m_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void FramePipeline::Kick(Step step) {
+    if (!m_thread.joinable()) {
+        m_step = std::move(step);
+        runStep();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_step = std::move(step);
+        m_busy = true;
+    }
+    m_wake.notify_one();
+}
+
+void FramePipeline::Wait() {
+    const Clock::time_point start = Clock::now();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return !m_busy; });
+    }
+    // Step timestamps are only read once the step has finished
+    m_stats.waitMs = toMs(Clock::now() - start);
+    m_stats.simulationMs = toMs(m_stepEnd - m_stepStart);
+
+    // The render interval measured since the step was kicked
+    const Clock::time_point overlapStart =
+        std::max(m_stepStart, m_renderStart);
+    const Clock::time_point overlapEnd = std::min(m_stepEnd, m_renderEnd);
+    m_stats.overlapMs =
+        overlapEnd > overlapStart ? toMs(overlapEnd - overlapStart) : 0.0f;
+}
+
+void FramePipeline::BeginRender() {
+    m_renderStart = Clock::now();
+}
+
+void FramePipeline::EndRender() {
+    m_renderEnd = Clock::now();
+    m_stats.renderMs = toMs(m_renderEnd - m_renderStart);
+}
+
+void FramePipeline::runStep() {
+    m_stepStart = Clock::now();
+    m_step();
+    m_step = nullptr;
+    m_stepEnd = Clock::now();
+}
+
+void FramePipeline::threadLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_busy || m_quit; });
+        if (m_quit)
+            return;
+
+        lock.unlock();
+        runStep();
+        lock.lock();
+        m_busy = false;
+        m_done.notify_one();
+    }
+}
+
+}  // namespace arena
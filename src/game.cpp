@@ -1,58 +1,287 @@
 #include "game.h"
+#include "asset_cache.h"
+#include "asset_loader.h"
 #include "debug.h"
 #include "logger.h"
 #include "raylib.h"
+#include "utils.h"
 #define RLIGHTS_IMPLEMENTATION
 #include "rlights.h"
 
 namespace arena {
 
+// Sort key pass of opaque meshes drawn through the render queue
+static const unsigned int OPAQUE_QUEUE_PASS = 0;
+
+// Player files prepared on a loader thread
+struct PlayerAssets {
+    std::shared_ptr<const AssetBlob> model;
+    std::shared_ptr<const AnimationClipSet> clips;
+};
+
 bool Game::Initialize() {
+    utils::Stopwatch timer;
+
+    // Serve repeated file loads from memory
+    AssetCache::Install();
+
+    // Read model files and decode animation clips on loader threads while
+    // the main thread compiles shaders. Models are uploaded below, on the
+    // main thread, once their bytes are in memory.
+    AssetLoader loader(m_settings.jobSettings.loaderThreads);
+    const char* terrainPath = m_settings.terrainSettings.model;
+    const PlayerSettings& playerSettings = m_settings.playerSettings;
+    std::future<std::shared_ptr<const AssetBlob>> terrainAsset =
+        loader.Load(terrainPath,
+                    [terrainPath] { return AssetCache::Acquire(terrainPath); });
+    std::future<PlayerAssets> playerAssets =
+        loader.Load(playerSettings.model, [&playerSettings] {
+            PlayerAssets assets;
+            assets.model = AssetCache::Acquire(playerSettings.model);
+            assets.clips = AnimationManager::PreloadAnimations(
+                playerSettings, playerSettings.model);
+            return assets;
+        });
 
     // Create a camera
     m_camera = std::make_unique<Camera>(m_settings.cameraSettings);
 
     // Load shaders
-    m_shaderHandler =
-        std::make_unique<ShaderHandler>(m_settings, m_camera.get());
+    m_shaderHandler = std::make_unique<ShaderHandler>(m_settings);
+    const LightingSettings& lightingSettings = m_settings.lightingSettings;
     if (!m_shaderHandler->Load("../assets/shaders/base_lighting.vs",
-                               "../assets/shaders/lighting.fs")) {
+                               lightingSettings.clustered
+                                   ? "../assets/shaders/clustered_lighting.fs"
+                                   : "../assets/shaders/lighting.fs")) {
         LOG_ERROR("Failed to load shader");
         return false;
     }
 
     // Load terrain
+    std::shared_ptr<const AssetBlob> terrainBytes = terrainAsset.get();
     m_terrain = std::make_unique<Terrain>(m_settings.terrainSettings);
     if (!m_terrain->Initialize()) {
         LOG_ERROR("Failed to initialize terrain");
         return false;
     }
+    m_terrainCullingId = m_culling.AddObject(m_terrain->GetMeshBounds());
+    if (lightingSettings.clustered) {
+        m_terrain->SetShader(m_shaderHandler->GetShader());
+    }
+    if (m_settings.occlusionSettings.enabled) {
+        m_occlusion =
+            std::make_unique<OcclusionCuller>(m_settings.occlusionSettings);
+        m_occlusion->SetOccluders(m_terrain->GetColliders());
+    }
 
     // Load player
+    PlayerAssets playerBytes = playerAssets.get();
     m_player = std::make_unique<Player>(m_settings, m_terrain.get());
     if (!m_player->Initialize()) {
         LOG_ERROR("Failed to initialize player");
         return false;
     }
 
+    // Predict the player locally against an in-process authority
+    if (m_settings.networkSettings.enablePrediction) {
+        m_prediction = std::make_unique<PredictionClient>(
+            m_settings.networkSettings, m_player->GetSimulation());
+        m_authority = std::make_unique<LocalAuthority>(
+            m_player->GetSimulation(), m_player->GetState(),
+            m_settings.networkSettings.simulatedLatency);
+    }
+
+    // Create crowd systems and register the player
+    m_characterCollision = std::make_unique<CharacterCollisionSystem>(
+        m_settings.physicsSettings);
+    m_aoiGrid = std::make_unique<AoiGrid>(m_settings.aoiSettings,
+                                          m_settings.terrainSettings);
+    m_lagCompensator = std::make_unique<LagCompensator>(
+        m_settings.lagCompensationSettings, m_settings.terrainSettings);
+    m_animationLod =
+        std::make_unique<AnimationLodSystem>(m_settings.animationLodSettings);
+    m_jobs = std::make_unique<JobSystem>(m_settings.jobSettings.workerThreads);
+    m_animationSystem = std::make_unique<AnimationSystem>(
+        m_settings.animationSystemSettings, *m_jobs);
+    registerCharacter(*m_player, m_playerHandles, true);
+
+    // Draw bots in batches, far ones sharing a posed model per clip
+    const InstancingSettings& instancingSettings =
+        m_settings.instancingSettings;
+    if (instancingSettings.enabled) {
+        m_instancing = std::make_unique<InstancedRenderer>(
+            instancingSettings.minInstances);
+        if (!m_instancing->Load("../assets/shaders/instancing.vs",
+                                "../assets/shaders/instancing.fs")) {
+            LOG_ERROR("Failed to load instancing shader");
+            return false;
+        }
+        if (instancingSettings.shareFarPoses &&
+            m_settings.botSettings.animated &&
+            m_settings.botSettings.count > 0) {
+            m_sharedPoses = std::make_unique<SharedPoses>(
+                m_settings.playerSettings, *m_animationSystem);
+            if (!m_sharedPoses->Initialize()) {
+                LOG_ERROR("Failed to create shared poses");
+                return false;
+            }
+        }
+    }
+
+    // Far bots draw as quads from a pre-rendered atlas
+    if (m_settings.impostorSettings.enabled &&
+        m_settings.botSettings.animated && m_settings.botSettings.count > 0) {
+        m_impostorSelector =
+            std::make_unique<ImpostorSelector>(m_settings.impostorSettings);
+        m_impostors =
+            std::make_unique<ImpostorRenderer>(m_settings.impostorSettings);
+        if (!m_impostors->Bake(m_settings.playerSettings)) {
+            LOG_ERROR("Failed to bake character impostors");
+            return false;
+        }
+    }
+
+    // Spawn simulation-only bots
+    if (!spawnBots()) {
+        LOG_ERROR("Failed to spawn bots");
+        return false;
+    }
+    if (m_settings.animationSystemSettings.measureScaling) {
+        m_animationSystem->MeasureScaling();
+    }
+
+    AssetCacheStats assetStats = AssetCache::GetStats();
+    LOG_INFO("Assets loaded in ", timer.ElapsedMs(), " ms: ",
+             assetStats.diskReads, " disk reads (", assetStats.bytesRead,
+             " bytes, ", assetStats.readTimeMs, " ms), ",
+             assetStats.cacheHits, " served from memory");
+
     // Add lights
     m_lights[0] = CreateLight(LIGHT_POINT, Vector3{0, 10, 0}, Vector3Zero(),
                               WHITE, m_shaderHandler->GetShader());
+    if (lightingSettings.clustered) {
+        createPointLights();
+        m_lightClusters = std::make_unique<LightClusters>(lightingSettings);
+        if (!m_lightClusters->Load(m_shaderHandler->GetShader())) {
+            LOG_ERROR("Failed to load light clusters");
+            return false;
+        }
+    }
+
+    // Debug shape categories shown at startup, F1 to F4 toggle them
+    const DebugDrawSettings& debugDrawSettings = m_settings.debugDrawSettings;
+    DebugDraw::SetEnabled(DEBUG_DRAW_COLLISION, debugDrawSettings.collision);
+    DebugDraw::SetEnabled(DEBUG_DRAW_TERRAIN, debugDrawSettings.terrain);
+    DebugDraw::SetEnabled(DEBUG_DRAW_LIGHTS, debugDrawSettings.lights);
+    DebugDraw::SetEnabled(DEBUG_DRAW_GRID, debugDrawSettings.grid);
+    createRenderPasses();
+
+    // The first frame is simulated before anything is drawn, later ones
+    // while the previous frame is drawn
+    m_pipeline =
+        std::make_unique<FramePipeline>(m_settings.jobSettings.pipelineFrames);
+    m_pipeline->Kick([this] { simulate(FrameInput(), m_packets[0]); });
 
     return true;
 }
 
 void Game::Update() {
-    float deltaTime = GetFrameTime();
+    // Collect the frame simulated while the previous one was drawn
+    m_pipeline->Wait();
+    m_renderPacket = m_simulationPacket;
+    DebugDraw::Swap();
+
+    // Its GPU half runs before the next step reuses the same buffers
+    m_shaderHandler->ResetFrameStats();
+    m_animationSystem->Upload();
+    m_shaderHandler->SetCameraPosition(renderPacket().camera.position);
+    m_shaderHandler->SetLight(m_lights[0]);
+
+    // Devices are only read on the main thread
+    FrameInput input;
+    input.deltaTime = GetFrameTime();
+    input.time = GetTime();
+    input.player = m_player->SampleInput(input.deltaTime);
+    input.cameraPitch = m_camera->SampleInput(input.deltaTime);
+    input.fire = IsMouseButtonPressed(MOUSE_RIGHT_BUTTON);
+    toggleDebugDraw();
+
+    // Simulate the next frame while this one is drawn
+    const int slot = 1 - m_renderPacket;
+    m_simulationPacket = slot;
+    m_pipeline->Kick([this, input, slot] { simulate(input, m_packets[slot]); });
+}
+
+void Game::simulate(const FrameInput& input, RenderPacket& packet) {
+    const float deltaTime = input.deltaTime;
+    m_aoiGrid->ResetFrameStats();
+    m_lagCompensator->ResetFrameStats();
+    m_animationLod->ResetFrameStats();
+    if (m_impostorSelector)
+        m_impostorSelector->ResetFrameStats();
+
+    // Pick the characters that pose and skin their animation this frame
+    m_animationLod->Update(m_camera->GetPosition());
+    applyAnimationLod(*m_player, m_playerHandles);
+    for (Bot& bot : m_bots) {
+        applyAnimationLod(*bot.player, bot.handles);
+    }
 
-    // Update lighting shader
-    m_shaderHandler->Update();
+    // Predicted moves are sent once separation has been applied
+    m_player->Update(deltaTime, input.player);
+
+    updateBots(deltaTime);
+
+    // Separate overlapping characters
+    m_characterCollision->SetPosition(m_playerHandles.collisionId,
+                                      m_player->GetState().position);
+    for (Bot& bot : m_bots) {
+        m_characterCollision->SetPosition(bot.handles.collisionId,
+                                          bot.player->GetState().position);
+    }
+    m_characterCollision->Resolve();
+    const Vector3 unseparated = m_player->GetState().position;
+    m_player->ApplySeparation(
+        m_characterCollision->GetCorrection(m_playerHandles.collisionId));
+    if (m_prediction) {
+        updatePredictedPlayer(
+            input, Vector3Subtract(m_player->GetState().position,
+                                   unseparated));
+    }
+    for (Bot& bot : m_bots) {
+        bot.player->ApplySeparation(
+            m_characterCollision->GetCorrection(bot.handles.collisionId));
+    }
 
-    m_player->Update(deltaTime, m_terrain->GetColliders());
     m_camera->Update(m_player->GetState().position,
-                     m_player->GetState().facingDirection, deltaTime);
+                     m_player->GetState().facingDirection, input.cameraPitch);
+
+    // Play every character's animation in parallel; the main thread
+    // uploads the results
+    m_animationSystem->Animate(deltaTime);
+
+    // Update area-of-interest visibility and record hitbox history
+    const PlayerState& playerState = m_player->GetState();
+    m_aoiGrid->MoveEntity(m_playerHandles.aoiId, playerState.position);
+    recordAnimationLod(*m_player, m_playerHandles);
+    for (Bot& bot : m_bots) {
+        const PlayerState& botState = bot.player->GetState();
+        m_aoiGrid->MoveEntity(bot.handles.aoiId, botState.position);
+        recordAnimationLod(*bot.player, bot.handles);
+    }
+    m_aoiGrid->Update();
+    recordHitboxes(deltaTime);
+    if (input.fire)
+        fireHitscan();
 
-    UpdateLightValues(m_shaderHandler->GetShader(), m_lights[0]);
+    writeRenderPacket(packet);
+
+    // Debug shapes queued here are drawn with this packet
+    m_terrain->DrawCollidingTriangle(playerState.collidingTriangleIndex,
+                                     playerState.position);
+    Player::DrawCollisionBox(playerState);
+    Player::DrawGroundHeightIndicator(playerState);
+    DrawLights();
 
     LOG_DEBUG("Camera position: ");
     debug::PrintVec3(m_camera->GetCamera().position);
@@ -60,56 +289,438 @@ void Game::Update() {
     debug::PrintVec3(m_camera->GetCamera().target);
 }
 
-void Game::Draw() {
-    BeginDrawing();
-    ClearBackground(RAYWHITE);
-    BeginMode3D(m_camera->GetCamera());
+void Game::recordHitboxes(const float deltaTime) {
+    // The history ring is sized for the tick rate, so record once per
+    // elapsed tick rather than once per frame. A long hitch records at
+    // most a full ring of the current state.
+    const LagCompensationSettings& settings =
+        m_settings.lagCompensationSettings;
+    const float tickInterval = 1.0f / settings.tickRate;
+    m_tickAccumulator += deltaTime;
+    int ticks = (int)(m_tickAccumulator / tickInterval);
+    m_tickAccumulator -= ticks * tickInterval;
+    ticks = std::min(ticks, m_lagCompensator->GetStats().historyCapacity);
 
-    m_terrain->Draw();
-    m_player->Draw();
+    for (int i = 0; i < ticks; i++) {
+        m_lagCompensator->BeginTick(m_tick++);
+        m_lagCompensator->Record(m_playerHandles.historyId,
+                                 m_player->GetState());
+        for (const Bot& bot : m_bots) {
+            m_lagCompensator->Record(bot.handles.historyId,
+                                     bot.player->GetState());
+        }
+    }
+}
 
-    m_shaderHandler->Update();
-    m_shaderHandler->Begin();
+void Game::fireHitscan() {
+    // Shoot along the view, against hitboxes as the client saw them one
+    // latency ago
+    const LagCompensationSettings& settings =
+        m_settings.lagCompensationSettings;
+    const Camera3D& camera = m_camera->GetCamera();
+    Ray ray;
+    ray.position = camera.position;
+    ray.direction =
+        Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+    const float rewindTick =
+        m_lagCompensator->GetNewestTick() -
+        m_settings.networkSettings.simulatedLatency * settings.tickRate;
 
-    m_terrain->Draw();
-    m_player->Draw();
+    RewindHit hit;
+    if (m_lagCompensator->Raycast(ray, settings.hitscanRange, rewindTick,
+                                  m_playerHandles.historyId, hit)) {
+        LOG_INFO("Hitscan hit entity ", hit.entityId, " at ", hit.distance,
+                 " m, rewound to tick ", rewindTick);
+        DebugDraw::Line(DEBUG_DRAW_COLLISION, ray.position, hit.point, RED);
+        DebugDraw::Sphere(DEBUG_DRAW_COLLISION, hit.point, 0.1f, RED);
+    } else {
+        LOG_INFO("Hitscan missed, rewound to tick ", rewindTick);
+        DebugDraw::Line(DEBUG_DRAW_COLLISION, ray.position,
+                        Vector3Add(ray.position,
+                                   Vector3Scale(ray.direction,
+                                                settings.hitscanRange)),
+                        GRAY);
+    }
+}
 
-    m_shaderHandler->End();
+void Game::writeRenderPacket(RenderPacket& packet) {
+    packet.frame = m_frame++;
+    packet.camera = m_camera->GetCamera();
+    packet.player = m_player->GetState();
 
-    // Draw debug stuff
-    m_terrain->DrawColliderEdges();
-    m_player->DrawCollisionBox();
-    m_player->DrawGroundHeightIndicator();
+    // Characters with a model, bots batched when instancing is on and
+    // drawn as impostors when far enough
+    packet.characters.clear();
+    const auto addCharacter = [this, &packet](const Player& player,
+                                              const CharacterHandles& handles,
+                                              const bool instanced) {
+        if (handles.cullingId < 0)
+            return;
+        const PlayerState& state = player.GetState();
+        CharacterDraw draw;
+        draw.model = &player.GetDrawnModel();
+        draw.transform = player.GetModelTransform();
+        draw.position = state.position;
+        draw.cullingId = handles.cullingId;
+        draw.instanced = instanced;
+        if (handles.impostorId >= 0) {
+            draw.impostorView = m_impostorSelector->Select(
+                handles.impostorId, state.position, state.rotationHorizontal,
+                packet.camera.position);
+        }
+        packet.characters.push_back(draw);
+    };
+    addCharacter(*m_player, m_playerHandles, false);
+    for (const Bot& bot : m_bots) {
+        addCharacter(*bot.player, bot.handles, m_instancing != nullptr);
+    }
 
-    // Draw lights
-    m_shaderHandler->Begin();
-    DrawLights();
-    m_shaderHandler->End();
+    SimulationStats& stats = packet.stats;
+    stats.aoi = m_aoiGrid->GetStats();
+    stats.aoiVisible =
+        (int)m_aoiGrid->GetVisibleEntities(m_playerHandles.aoiId).size();
+    stats.lagCompensation = m_lagCompensator->GetStats();
+    stats.characterCollision = m_characterCollision->GetStats();
+    stats.prediction = m_prediction != nullptr;
+    if (m_prediction)
+        stats.predictionStats = m_prediction->GetStats();
+    const AnimationManager* animation = m_player->GetAnimationManager();
+    stats.playerAnimated = animation != nullptr;
+    if (animation)
+        stats.blend = animation->GetBlendStats();
+    stats.animationLod = m_animationLod->GetStats();
+    stats.animationSystem = m_animationSystem->GetStats();
+    if (m_impostorSelector)
+        stats.impostors = m_impostorSelector->GetStats();
+}
 
-    // Draw other elements
-    DrawGrid(10, 1.0f);
-    EndMode3D();
+void Game::registerCharacter(Player& player, CharacterHandles& handles,
+                             const bool observer) {
+    const PlayerState& state = player.GetState();
+    handles.collisionId = m_characterCollision->AddCharacter(
+        state.position, state.radius, state.height);
+    handles.aoiId = m_aoiGrid->AddEntity(state.position);
+    if (observer) {
+        m_aoiGrid->AddObserver(handles.aoiId,
+                               m_settings.aoiSettings.viewRadius);
+    }
+    handles.historyId = m_lagCompensator->AddEntity();
+    if (player.GetMode() == PlayerMode::Full) {
+        handles.cullingId = m_culling.AddObject({player.GetBounds()});
+        if (m_impostorSelector && !observer)
+            handles.impostorId = m_impostorSelector->AddCharacter();
+    }
+    if (player.GetAnimationManager()) {
+        handles.animationLodId = m_animationLod->AddCharacter(state.position);
+        m_animationSystem->Add(player.GetAnimationManager());
+    }
+}
+
+void Game::unregisterCharacter(Player& player, CharacterHandles& handles) {
+    m_characterCollision->RemoveCharacter(handles.collisionId);
+    m_aoiGrid->RemoveEntity(handles.aoiId);
+    m_lagCompensator->RemoveEntity(handles.historyId);
+    m_animationLod->RemoveCharacter(handles.animationLodId);
+    m_culling.RemoveObject(handles.cullingId);
+    if (m_impostorSelector)
+        m_impostorSelector->RemoveCharacter(handles.impostorId);
+    if (player.GetAnimationManager()) {
+        m_animationSystem->Remove(player.GetAnimationManager());
+    }
+    handles = CharacterHandles();
+}
+
+bool Game::spawnBots() {
+    const BotSettings& botSettings = m_settings.botSettings;
+    if (botSettings.count <= 0)
+        return true;
 
-    // Draw UI elements
-    DrawDebugUi();
+    utils::Stopwatch timer;
+    const Vector3 center = m_settings.playerSettings.initialPlayerPosition;
+
+    // Every animated bot loads the same model file
+    std::shared_ptr<const AssetBlob> asset;
+    if (botSettings.animated)
+        asset = AssetCache::Acquire(m_settings.playerSettings.model);
+    for (int i = 0; i < botSettings.count; i++) {
+        Bot bot;
+        bot.player = std::make_unique<Player>(
+            m_settings, m_terrain.get(),
+            botSettings.animated ? PlayerMode::Full
+                                 : PlayerMode::SimulationOnly);
+        if (!bot.player->Initialize())
+            return false;
+
+        // Scatter bots around the player spawn point
+        PlayerState state = bot.player->GetState();
+        float angle = GetRandomValue(0, 359) * DEG2RAD;
+        float distance =
+            botSettings.spawnRadius * GetRandomValue(10, 100) / 100.0f;
+        state.position.x = center.x + cosf(angle) * distance;
+        state.position.z = center.z + sinf(angle) * distance;
+        bot.player->SetState(state);
+
+        registerCharacter(*bot.player, bot.handles, false);
+        m_bots.push_back(std::move(bot));
+    }
+
+    double elapsed = timer.ElapsedMs();
+    LOG_INFO("Spawned ", botSettings.count,
+             botSettings.animated ? " animated" : " simulation-only",
+             " bots in ",
+             elapsed, " ms (", elapsed * 1000.0 / botSettings.count,
+             " us and ", sizeof(Player), " bytes each)");
+    return true;
+}
+
+void Game::despawnBots() {
+    if (m_bots.empty())
+        return;
+
+    utils::Stopwatch timer;
+    size_t count = m_bots.size();
+    for (Bot& bot : m_bots) {
+        unregisterCharacter(*bot.player, bot.handles);
+    }
+    m_bots.clear();
+    LOG_INFO("Destroyed ", count, " bots in ", timer.ElapsedMs(), " ms");
+}
+
+void Game::updateBots(const float deltaTime) {
+    const BotSettings& botSettings = m_settings.botSettings;
+    for (Bot& bot : m_bots) {
+        // Wander: pick a new direction every few seconds
+        bot.wanderTimer -= deltaTime;
+        if (bot.wanderTimer <= 0.0f) {
+            bot.wanderTimer = botSettings.wanderInterval *
+                              GetRandomValue(50, 150) / 100.0f;
+            bot.input.moveDirection =
+                Vector3{(float)GetRandomValue(-1, 1), 0,
+                        (float)GetRandomValue(-1, 1)};
+            bot.input.rotationDelta = (float)GetRandomValue(-90, 90);
+        } else {
+            bot.input.rotationDelta = 0.0f;
+        }
+
+        bot.player->Update(deltaTime, bot.input);
+    }
+}
+
+void Game::applyAnimationLod(Player& player, const CharacterHandles& handles) {
+    if (handles.animationLodId < 0)
+        return;
+    const AnimationLodTier tier =
+        m_animationLod->GetTier(handles.animationLodId);
+    if (m_sharedPoses && tier == AnimationLodTier::Far) {
+        // Far characters draw the shared pose of their clip, their own
+        // pose is not seen until they come closer
+        const Model* shared = m_sharedPoses->GetModel(
+            player.GetAnimationManager()->GetCurrentAnimation());
+        player.SetSharedModel(shared);
+        if (shared) {
+            player.SetAnimationUpdate(false);
+            return;
+        }
+    } else {
+        player.SetSharedModel(nullptr);
+    }
+    player.SetAnimationUpdate(
+        m_animationLod->ShouldUpdate(handles.animationLodId));
+}
+
+void Game::recordAnimationLod(const Player& player,
+                              const CharacterHandles& handles) {
+    if (handles.animationLodId < 0)
+        return;
+    m_animationLod->SetPosition(handles.animationLodId,
+                                player.GetState().position);
+    if (m_animationLod->ShouldUpdate(handles.animationLodId)) {
+        m_animationLod->RecordUpdate(
+            player.GetAnimationManager()->GetLastUpdateTimeMs());
+    }
+}
+
+void Game::updatePredictedPlayer(const FrameInput& input,
+                                 const Vector3& separation) {
+    const double now = input.time;
+    m_prediction->ResetFrameStats();
+
+    // The player already stepped and separated locally; send the same
+    // input and push to the authority
+    InputCommand command = m_prediction->CreateCommand(
+        input.player, input.deltaTime, separation);
+    m_prediction->StorePrediction(command, m_player->GetState());
+    m_authority->Send(command, now);
+    m_authority->Update(now);
+
+    // Correct the prediction from the newest authoritative snapshot
+    StateSnapshot snapshot(m_player->GetState());
+    if (m_authority->ReceiveSnapshot(now, snapshot)) {
+        PlayerState state = m_player->GetState();
+        if (m_prediction->Reconcile(snapshot, state)) {
+            m_player->SetState(state);
+        }
+    }
+}
+
+void Game::createPointLights() {
+    // Spread the lights over the map in a grid
+    const LightingSettings& settings = m_settings.lightingSettings;
+    const TerrainSettings& terrain = m_settings.terrainSettings;
+    const Color colors[] = {RED, ORANGE, YELLOW, GREEN, SKYBLUE, BLUE, PURPLE};
+    const int colorCount = sizeof(colors) / sizeof(colors[0]);
+    const int columns = (int)ceilf(sqrtf((float)settings.pointLights));
+    const int rows = (settings.pointLights + columns - 1) / columns;
+    for (int i = 0; i < settings.pointLights; i++) {
+        PointLight light;
+        light.position = Vector3{
+            terrain.mapWidth * ((i % columns + 0.5f) / columns - 0.5f),
+            settings.pointLightHeight,
+            terrain.mapDepth * ((i / columns + 0.5f) / rows - 0.5f)};
+        light.radius = settings.pointLightRadius;
+        light.color = colors[i % colorCount];
+        m_pointLights.push_back(light);
+    }
+}
+
+void Game::createRenderPasses() {
+    // Each drawable belongs to exactly one pass
+    m_renderGraph.AddPass(
+        "opaque", RENDER_INPUT_CAMERA | RENDER_INPUT_LIGHTING, [this] {
+            // Meshes drawn one by one are sorted by state, then front to
+            // back. Bots sharing buffers and material draw together.
+            const RenderPacket& packet = renderPacket();
+            m_renderQueue.Begin(packet.camera.position);
+            m_terrain->Submit(m_renderQueue, OPAQUE_QUEUE_PASS, m_culling,
+                              m_terrainCullingId);
+            if (m_instancing)
+                m_instancing->Begin();
+            for (const CharacterDraw& draw : packet.characters) {
+                if (draw.impostorView >= 0 ||
+                    !m_culling.IsVisible(draw.cullingId))
+                    continue;
+                if (draw.instanced) {
+                    m_instancing->AddModel(*draw.model, draw.transform);
+                } else {
+                    m_renderQueue.AddModel(OPAQUE_QUEUE_PASS, *draw.model,
+                                           draw.transform, draw.position);
+                }
+            }
+            m_renderQueue.Sort();
+            int drawCalls = m_renderQueue.Draw();
+            if (m_instancing)
+                drawCalls += m_instancing->Draw();
+            return drawCalls;
+        });
+    m_renderGraph.AddPass(
+        "lights", RENDER_INPUT_CAMERA | RENDER_INPUT_LIGHTING, [this] {
+            // Clustered lights are small markers, batched with the rest
+            for (const PointLight& light : m_pointLights) {
+                DrawSphereEx(light.position, 0.1f, 4, 4, light.color);
+            }
+            return 1;
+        });
+    m_renderGraph.AddPass("impostors", RENDER_INPUT_CAMERA, [this] {
+        // Unlit like the character models, all quads in one batch
+        if (!m_impostors)
+            return 0;
+        const RenderPacket& packet = renderPacket();
+        m_impostors->Begin(packet.camera.position);
+        for (const CharacterDraw& draw : packet.characters) {
+            if (draw.impostorView >= 0 && m_culling.IsVisible(draw.cullingId))
+                m_impostors->Add(draw.position, draw.impostorView);
+        }
+        return m_impostors->Draw();
+    });
+    m_renderGraph.AddPass("debug", RENDER_INPUT_CAMERA, [this] {
+        // Shapes the simulation queued for this packet, then static ones
+        // too large to queue every frame
+        int drawCalls = DebugDraw::Flush();
+        if (DebugDraw::IsEnabled(DEBUG_DRAW_TERRAIN)) {
+            m_terrain->DrawColliderEdges();
+            drawCalls++;
+        }
+        if (DebugDraw::IsEnabled(DEBUG_DRAW_GRID)) {
+            DrawGrid(10, 1.0f);
+            drawCalls++;
+        }
+        return drawCalls;
+    });
+    m_renderGraph.AddPass("ui", 0, [this] {
+        DebugDraw::FlushText(renderPacket().camera);
+        DrawDebugUi();
+        return 1;
+    });
+}
+
+void Game::cullScene() {
+    const RenderPacket& packet = renderPacket();
+    for (const CharacterDraw& draw : packet.characters) {
+        m_culling.SetPosition(draw.cullingId, draw.position);
+    }
+    const Matrix viewProjection = GetCameraViewProjection(
+        packet.camera, (float)GetScreenWidth() / GetScreenHeight());
+    m_culling.Cull(Frustum::FromMatrix(viewProjection));
+
+    // Terrain walls hide what is behind them
+    if (m_occlusion) {
+        m_occlusion->Render(viewProjection);
+        m_culling.ApplyOcclusion(*m_occlusion);
+    }
+}
+
+void Game::Draw() {
+    // Runs while the simulation thread steps the next frame, and reads
+    // only the render packet of the simulated state
+    m_pipeline->BeginRender();
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+    const RenderPacket& packet = renderPacket();
+    if (m_lightClusters) {
+        m_lightClusters->Build(m_pointLights, packet.camera,
+                               (float)GetScreenWidth() / GetScreenHeight());
+        m_lightClusters->Upload(m_pointLights, GetScreenWidth(),
+                                GetScreenHeight());
+    }
+    cullScene();
+
+    // The lighting shader was updated in Update()
+    m_renderGraph.Execute(packet.camera, m_shaderHandler->GetShader());
+    m_pipeline->EndRender();
 
     EndDrawing();
+
+    if (!m_firstFrameDrawn) {
+        m_firstFrameDrawn = true;
+        LOG_INFO("Time to first frame: ", m_startupTimer.ElapsedMs(), " ms");
+    }
 }
 
 void Game::DrawDebugUi() const {
-    DrawText("Move with WASD, Jump with SPACE, Look around with Mouse", 10, 10,
-             20, DARKGRAY);
+    DrawText("Move with WASD, Jump with SPACE, Look around with Mouse, "
+             "Shoot with right click",
+             10, 10, 20, DARKGRAY);
     DrawFPS(10, 40);  // Display the FPS at coordinates (10, 40)
 
+    const PipelineStats& pipelineStats = m_pipeline->GetStats();
+    DrawText(TextFormat("Pipeline: simulation %.3f ms, render %.3f ms, "
+                        "overlap %.3f ms, waited %.3f ms",
+                        pipelineStats.simulationMs, pipelineStats.renderMs,
+                        pipelineStats.overlapMs, pipelineStats.waitMs),
+             10, 70, 20, DARKGRAY);
+
     //DrawText(TextFormat("Position: %.2f, %.2f, %.2f", playerPosition.x, playerPosition.y, playerPosition.z), 10, 40, 20, BLACK);
     //DrawText(TextFormat("Velocity Y: %.2f", velocityY), 10, 70, 20, BLACK);
 
-    PlayerState playerState = m_player->GetState();
+    // Simulation state comes from the packet being drawn
+    const RenderPacket& packet = renderPacket();
+    const SimulationStats& stats = packet.stats;
+    const PlayerState& playerState = packet.player;
     Vector3 playerPosition = playerState.position;
     DrawText(TextFormat("Player Position: (%.2f, %.2f, %.2f)", playerPosition.x,
                         playerPosition.y, playerPosition.z),
              10, 100, 20, DARKGRAY);
-    DrawText(TextFormat("Velocity Y: %.2f", m_player->GetState().velocity.y),
+    DrawText(TextFormat("Velocity Y: %.2f", playerState.velocity.y),
              10, 130, 20, DARKGRAY);
     DrawText(TextFormat("Is Jumping: %s", playerState.isJumping ? "Yes" : "No"),
              10, 160, 20, DARKGRAY);
@@ -126,20 +737,187 @@ void Game::DrawDebugUi() const {
                         playerState.velocity.x, playerState.velocity.y,
                         playerState.velocity.z),
              10, 250, 20, DARKGRAY);
+
+    const AoiStats& aoiStats = stats.aoi;
+    DrawText(TextFormat("AOI: %d entities, %d visible, moves %d (%.3f ms), "
+                        "queries %d/%d tested (%.3f ms)",
+                        aoiStats.entityCount,
+                        stats.aoiVisible,
+                        aoiStats.moves, aoiStats.moveTimeMs, aoiStats.queries,
+                        aoiStats.candidatesTested, aoiStats.queryTimeMs),
+             10, 280, 20, DARKGRAY);
+
+    const LagCompensationStats& lagStats = stats.lagCompensation;
+    DrawText(TextFormat("Hit history: %d entities, %d ticks, %d B/entity, "
+                        "last query %.3f ms (max %.3f ms)",
+                        lagStats.entityCount, lagStats.historyCapacity,
+                        (int)lagStats.bytesPerEntity, lagStats.lastQueryMs,
+                        lagStats.maxQueryMs),
+             10, 310, 20, DARKGRAY);
+
+    const CharacterCollisionStats& collisionStats = stats.characterCollision;
+    DrawText(TextFormat("Character collision: %d characters, %d swaps, "
+                        "%d pairs, %d contacts (%.3f ms)",
+                        collisionStats.characterCount, collisionStats.sortSwaps,
+                        collisionStats.pairsTested, collisionStats.contacts,
+                        collisionStats.resolveTimeMs),
+             10, 340, 20, DARKGRAY);
+
+    if (stats.prediction) {
+        const PredictionStats& predictionStats = stats.predictionStats;
+        DrawText(TextFormat("Prediction: %d pending, %.1f%% mispredicted, "
+                            "%d replayed, reconcile %.3f ms",
+                            predictionStats.pendingInputs,
+                            predictionStats.MispredictionRate() * 100.0f,
+                            predictionStats.replayedInputs,
+                            predictionStats.reconcileTimeMs),
+                 10, 370, 20, DARKGRAY);
+    }
+
+    DrawText(TextFormat("Animation library: %d assets, %.1f KB clips, "
+                        "%.1f KB baked poses",
+                        AnimationLibrary::GetLoadedAssetCount(),
+                        AnimationLibrary::GetLoadedBytes() / 1024.0f,
+                        AnimationLibrary::GetBakedBytes() / 1024.0f),
+             10, 400, 20, DARKGRAY);
+
+    if (stats.playerAnimated) {
+        const AnimationBlendStats& blendStats = stats.blend;
+        DrawText(TextFormat("Animation blend: %d layers, %.3f ms "
+                            "(max %.3f ms), %d dropped",
+                            blendStats.activeLayers, blendStats.blendTimeMs,
+                            blendStats.maxBlendTimeMs,
+                            blendStats.droppedLayers),
+                 10, 430, 20, DARKGRAY);
+    }
+
+    const AnimationLodStats& lodStats = stats.animationLod;
+    DrawText(TextFormat("Animation LOD: %d/%d/%d near/mid/far, %d updated, "
+                        "%d throttled, %d deferred, %.3f ms (saved %.3f ms)",
+                        lodStats.characters[0], lodStats.characters[1],
+                        lodStats.characters[2], lodStats.updated,
+                        lodStats.throttled, lodStats.deferred,
+                        lodStats.updateTimeMs, lodStats.savedTimeMs),
+             10, 460, 20, DARKGRAY);
+
+    const AnimationSystemStats& systemStats = stats.animationSystem;
+    DrawText(TextFormat("Animation system: %d characters on %d threads, "
+                        "animate %.3f ms, upload %.3f ms",
+                        systemStats.instances, systemStats.threads,
+                        systemStats.animateTimeMs, systemStats.uploadTimeMs),
+             10, 490, 20, DARKGRAY);
+
+    // Timings are from the previous frame; the UI pass is still running
+    std::string passes;
+    for (const RenderPassStats& pass : m_renderGraph.GetStats()) {
+        passes += TextFormat(", %s %d (%.3f ms)", pass.name.c_str(),
+                             pass.drawCalls, pass.timeMs);
+    }
+    DrawText(TextFormat("Render: %d draw calls%s", m_renderGraph.GetDrawCalls(),
+                        passes.c_str()),
+             10, 520, 20, DARKGRAY);
+
+    const ShaderUniformStats& uniformStats = m_shaderHandler->GetStats();
+    DrawText(TextFormat("Shader uniforms: %d uploaded, %d skipped",
+                        uniformStats.uploaded, uniformStats.skipped),
+             10, 550, 20, DARKGRAY);
+
+    const CullingStats& cullingStats = m_culling.GetStats();
+    DrawText(TextFormat("Culling: %d/%d objects, %d/%d meshes visible, "
+                        "%d/%d occluded, %d boxes tested (%.3f ms)",
+                        cullingStats.visibleObjects, cullingStats.objects,
+                        cullingStats.visibleMeshes, cullingStats.meshes,
+                        cullingStats.occludedObjects,
+                        cullingStats.occludedMeshes, cullingStats.boxesTested,
+                        cullingStats.cullTimeMs),
+             10, 580, 20, DARKGRAY);
+
+    if (m_occlusion) {
+        const OcclusionStats& occlusionStats = m_occlusion->GetStats();
+        DrawText(TextFormat("Occlusion: %d/%d occluder triangles, "
+                            "raster %.3f ms, %d/%d boxes hidden (%.3f ms)",
+                            occlusionStats.rasterizedTriangles,
+                            occlusionStats.occluderTriangles,
+                            occlusionStats.rasterTimeMs,
+                            occlusionStats.occludedBoxes,
+                            occlusionStats.testedBoxes,
+                            occlusionStats.testTimeMs),
+                 10, 610, 20, DARKGRAY);
+    }
+
+    if (m_instancing || m_impostors) {
+        // Impostors share the crowd line, the overlay has no room left
+        const InstancingStats instancingStats =
+            m_instancing ? m_instancing->GetStats() : InstancingStats();
+        const ImpostorStats impostorStats =
+            m_impostors ? m_impostors->GetStats() : ImpostorStats();
+        DrawText(TextFormat("Instancing: %d meshes in %d batches, "
+                            "%d instanced, %d draw calls, %d shared poses, "
+                            "%d/%d impostors (%d switched)",
+                            instancingStats.instances, instancingStats.batches,
+                            instancingStats.instancedBatches,
+                            instancingStats.drawCalls,
+                            m_sharedPoses ? m_sharedPoses->GetCount() : 0,
+                            impostorStats.quads,
+                            renderPacket().stats.impostors.impostors,
+                            renderPacket().stats.impostors.switches),
+                 10, 640, 20, DARKGRAY);
+    }
+
+    const RenderQueueStats& queueStats = m_renderQueue.GetStats();
+    DrawText(TextFormat("Render queue: %d items, %d state changes sorted "
+                        "(%d unsorted), %d radix passes (%.3f ms)",
+                        queueStats.items, queueStats.stateChangesAfter,
+                        queueStats.stateChangesBefore, queueStats.sortPasses,
+                        queueStats.sortTimeMs),
+             10, 670, 20, DARKGRAY);
+
+    if (m_lightClusters) {
+        const LightClusterStats& clusterStats = m_lightClusters->GetStats();
+        DrawText(TextFormat("Light clusters: %d/%d lights, %d assignments, "
+                            "max %d per cluster (%.3f ms)",
+                            clusterStats.visibleLights, clusterStats.lights,
+                            clusterStats.assignments,
+                            clusterStats.maxClusterLights,
+                            clusterStats.buildTimeMs),
+                 10, 700, 20, DARKGRAY);
+    }
 }
 
 void Game::DrawLights() const {
-    DrawSphereWires(m_lights[0].position, 0.2f, 8, 8, YELLOW);
-    DrawLine3D(m_lights[0].position,
-               Vector3Add(m_lights[0].position,
-                          Vector3Scale(m_lights[0].target, 5.0f)),
-               YELLOW);
+    DebugDraw::Sphere(DEBUG_DRAW_LIGHTS, m_lights[0].position, 0.2f, YELLOW);
+    DebugDraw::Line(DEBUG_DRAW_LIGHTS, m_lights[0].position,
+                    Vector3Add(m_lights[0].position,
+                               Vector3Scale(m_lights[0].target, 5.0f)),
+                    YELLOW);
 
-    DrawSphereEx(m_lights[0].position, 0.2f, 8, 8, m_lights[0].color);
+    DebugDraw::Sphere(DEBUG_DRAW_LIGHTS, m_lights[0].position, 0.15f,
+                      m_lights[0].color);
+    DebugDraw::Text(DEBUG_DRAW_LIGHTS,
+                    Vector3Add(m_lights[0].position, Vector3{0, 0.5f, 0}),
+                    "Light 0", DARKGRAY);
+}
+
+void Game::toggleDebugDraw() {
+    // F1 to F4 show and hide debug shapes by category
+    static const unsigned int CATEGORIES[] = {
+        DEBUG_DRAW_COLLISION, DEBUG_DRAW_TERRAIN, DEBUG_DRAW_LIGHTS,
+        DEBUG_DRAW_GRID};
+    for (int i = 0; i < 4; i++) {
+        if (IsKeyPressed(KEY_F1 + i))
+            DebugDraw::Toggle(CATEGORIES[i]);
+    }
 }
 
 void Game::Cleanup() {
     // Unload resources, close window
+    m_pipeline.reset();
+    despawnBots();
+    m_sharedPoses.reset();
+    m_instancing.reset();
+    m_impostors.reset();
+    m_impostorSelector.reset();
+    m_lightClusters.reset();
 }
 
 }  // namespace arena
@@ -0,0 +1,74 @@
+#include "impostor_selector.h"
+#include <cmath>
+#include "raymath.h"
+
+namespace arena {
+
+ImpostorSelector::ImpostorSelector(const ImpostorSettings& settings)
+    : m_settings(settings) {}
+
+int ImpostorSelector::AddCharacter() {
+    int id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = (int)m_impostor.size();
+        m_impostor.push_back(0);
+        m_active.push_back(0);
+    }
+    m_impostor[id] = 0;
+    m_active[id] = 1;
+    return id;
+}
+
+void ImpostorSelector::RemoveCharacter(const int id) {
+    if (id < 0 || id >= (int)m_active.size() || !m_active[id])
+        return;
+    m_active[id] = 0;
+    m_freeIds.push_back(id);
+}
+
+int ImpostorSelector::Select(const int id, const Vector3& position,
+                             const float yaw, const Vector3& viewPosition) {
+    m_stats.characters++;
+
+    // Hysteresis keeps characters near the switch distance from flickering
+    // between mesh and quad
+    float boundary = m_settings.distance;
+    boundary += m_impostor[id] ? -m_settings.hysteresis
+                               : m_settings.hysteresis;
+    const bool impostor =
+        Vector3DistanceSqr(position, viewPosition) > boundary * boundary;
+    if (impostor != (m_impostor[id] != 0))
+        m_stats.switches++;
+    m_impostor[id] = impostor ? 1 : 0;
+    if (!impostor)
+        return -1;
+
+    m_stats.impostors++;
+    return GetView(position, yaw, viewPosition, m_settings.viewAngles);
+}
+
+int ImpostorSelector::GetView(const Vector3& position, const float yaw,
+                              const Vector3& viewPosition,
+                              const int viewCount) {
+    if (viewCount <= 1)
+        return 0;
+
+    // Direction to the viewer in the character's own frame, where view i
+    // was rendered from angle 2 * PI * i / viewCount about the Y axis
+    const float angle = atan2f(viewPosition.x - position.x,
+                               viewPosition.z - position.z) - yaw;
+    const float step = 2.0f * PI / viewCount;
+    int view = (int)floorf(angle / step + 0.5f) % viewCount;
+    if (view < 0)
+        view += viewCount;
+    return view;
+}
+
+void ImpostorSelector::ResetFrameStats() {
+    m_stats = ImpostorStats();
+}
+
+}  // namespace arena
@@ -0,0 +1,173 @@
+#include "impostors.h"
+#include <algorithm>
+#include <cmath>
+#include "animation.h"
+#include "asset_cache.h"
+#include "logger.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+namespace arena {
+
+ImpostorRenderer::ImpostorRenderer(const ImpostorSettings& settings)
+    : m_settings(settings) {}
+
+ImpostorRenderer::~ImpostorRenderer() {
+    if (m_atlas.id != 0)
+        UnloadRenderTexture(m_atlas);
+}
+
+bool ImpostorRenderer::Bake(const PlayerSettings& playerSettings) {
+    // The model and its clips live in the same file, read it once
+    std::shared_ptr<const AssetBlob> asset =
+        AssetCache::Acquire(playerSettings.model);
+
+    Model model = LoadModel(playerSettings.model);
+    if (model.meshCount == 0) {
+        LOG_ERROR("Failed to load impostor model: ", playerSettings.model);
+        return false;
+    }
+
+    // Pose the model with the first frame of its initial clip, the bind
+    // pose is not one characters are ever seen in
+    {
+        AnimationManager animation(playerSettings);
+        if (animation.LoadAnimations(playerSettings.model) &&
+            animation.BindModel(model)) {
+            animation.SetAnimationByName(playerSettings.initialAnimationName);
+            animation.UpdateAnimation(0.0f);
+        } else {
+            LOG_WARNING("Impostors use the bind pose, animations unavailable");
+        }
+    }
+
+    // Every view frames the same square, centred on the character's axis
+    // so quads pivot where the character stands. Padded for the pose.
+    const float padding = 1.1f;
+    const Vector3 scale = playerSettings.initialPlayerScale;
+    const BoundingBox bounds = GetModelBoundingBox(model);
+    const float reachX =
+        std::max(fabsf(bounds.min.x), fabsf(bounds.max.x)) * scale.x;
+    const float reachZ =
+        std::max(fabsf(bounds.min.z), fabsf(bounds.max.z)) * scale.z;
+    const float centreY = (bounds.min.y + bounds.max.y) / 2 * scale.y;
+    const float halfHeight = (bounds.max.y - bounds.min.y) / 2 * scale.y;
+    const float half =
+        std::max(sqrtf(reachX * reachX + reachZ * reachZ), halfHeight) *
+        padding;
+    m_size = half * 2;
+    m_centre = Vector3{0.0f,
+                       centreY - playerSettings.initialPlayerHeight / 2,
+                       0.0f};
+
+    const int views = std::max(m_settings.viewAngles, 1);
+    const int cell = m_settings.cellSize;
+    m_atlas = LoadRenderTexture(cell * views, cell);
+    if (m_atlas.id == 0) {
+        LOG_ERROR("Failed to create impostor atlas");
+        UnloadModel(model);
+        return false;
+    }
+
+    const float distance = half * 4;
+    BeginTextureMode(m_atlas);
+    ClearBackground(BLANK);
+    for (int view = 0; view < views; view++) {
+        const float angle = 2.0f * PI * view / views;
+        Camera3D camera = {0};
+        camera.target = Vector3{0.0f, centreY, 0.0f};
+        camera.position = Vector3{sinf(angle) * distance, centreY,
+                                  cosf(angle) * distance};
+        camera.up = Vector3{0.0f, 1.0f, 0.0f};
+        camera.fovy = m_size;
+        camera.projection = CAMERA_ORTHOGRAPHIC;
+
+        rlViewport(view * cell, 0, cell, cell);
+        BeginMode3D(camera);
+        // BeginMode3D sizes the projection for the whole atlas, square it
+        // for the cell
+        rlMatrixMode(RL_PROJECTION);
+        rlLoadIdentity();
+        rlOrtho(-half, half, -half, half, 0.01, distance * 2);
+        rlMatrixMode(RL_MODELVIEW);
+        DrawModelEx(model, Vector3{0.0f, 0.0f, 0.0f}, Vector3{0, 1, 0}, 0.0f,
+                    scale, WHITE);
+        EndMode3D();
+    }
+    EndTextureMode();
+    SetTextureFilter(m_atlas.texture, TEXTURE_FILTER_BILINEAR);
+    UnloadModel(model);
+
+    LOG_INFO("Baked ", views, " impostor views into a ", cell * views, "x",
+             cell, " atlas");
+    return true;
+}
+
+void ImpostorRenderer::Begin(const Vector3& viewPosition) {
+    m_viewPosition = viewPosition;
+    m_quads.clear();
+}
+
+void ImpostorRenderer::Add(const Vector3& position, const int view) {
+    Quad quad;
+    quad.position = Vector3Add(position, m_centre);
+    quad.view = view;
+    quad.distance = Vector3DistanceSqr(quad.position, m_viewPosition);
+    m_quads.push_back(quad);
+}
+
+int ImpostorRenderer::Draw() {
+    m_stats.quads = (int)m_quads.size();
+    m_stats.drawCalls = 0;
+    if (m_quads.empty() || m_atlas.id == 0)
+        return 0;
+
+    // Far quads first, so the soft edges of near ones blend over them
+    std::sort(m_quads.begin(), m_quads.end(),
+              [](const Quad& a, const Quad& b) {
+                  return a.distance > b.distance;
+              });
+
+    const float half = m_size / 2;
+    const float cellWidth = 1.0f / std::max(m_settings.viewAngles, 1);
+    rlSetTexture(m_atlas.texture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(255, 255, 255, 255);
+    for (const Quad& quad : m_quads) {
+        // Upright quad turned to face the viewer about the Y axis. The
+        // atlas was rendered upside down, so v runs bottom to top.
+        const Vector3& c = quad.position;
+        float facingX = m_viewPosition.x - c.x;
+        float facingZ = m_viewPosition.z - c.z;
+        const float length = sqrtf(facingX * facingX + facingZ * facingZ);
+        if (length > 0.0001f) {
+            facingX /= length;
+            facingZ /= length;
+        } else {
+            facingX = 0.0f;
+            facingZ = 1.0f;
+        }
+        const float rightX = facingZ * half;
+        const float rightZ = -facingX * half;
+        const float u = quad.view * cellWidth;
+
+        rlNormal3f(facingX, 0.0f, facingZ);
+        rlTexCoord2f(u, 0.0f);
+        rlVertex3f(c.x - rightX, c.y - half, c.z - rightZ);
+        rlTexCoord2f(u + cellWidth, 0.0f);
+        rlVertex3f(c.x + rightX, c.y - half, c.z + rightZ);
+        rlTexCoord2f(u + cellWidth, 1.0f);
+        rlVertex3f(c.x + rightX, c.y + half, c.z + rightZ);
+        rlTexCoord2f(u, 1.0f);
+        rlVertex3f(c.x - rightX, c.y + half, c.z - rightZ);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    // One batch, unless the quads overflow rlgl's batch buffer
+    const int batchQuads = RL_DEFAULT_BATCH_BUFFER_ELEMENTS;
+    m_stats.drawCalls = ((int)m_quads.size() + batchQuads - 1) / batchQuads;
+    return m_stats.drawCalls;
+}
+
+}  // namespace arena
@@ -0,0 +1,95 @@
+#include "instancing.h"
+#include <algorithm>
+#include <tuple>
+#include "logger.h"
+#include "raymath.h"
+
+namespace arena {
+
+bool InstancedRenderer::BatchKey::operator<(const BatchKey& other) const {
+    return std::tie(vao, vbo, shader, texture) <
+           std::tie(other.vao, other.vbo, other.shader, other.texture);
+}
+
+InstancedRenderer::InstancedRenderer(const int minInstances)
+    : m_minInstances(std::max(minInstances, 2)) {}
+
+InstancedRenderer::~InstancedRenderer() {
+    if (m_shader.id > 0)
+        UnloadShader(m_shader);
+}
+
+bool InstancedRenderer::Load(const char* vertexShaderPath,
+                             const char* fragmentShaderPath) {
+    m_shader = LoadShader(vertexShaderPath, fragmentShaderPath);
+    if (!IsShaderReady(m_shader)) {
+        LOG_ERROR("Failed to load instancing shader");
+        return false;
+    }
+
+    // The model matrix arrives per instance as a vertex attribute
+    m_shader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(m_shader, "mvp");
+    m_shader.locs[SHADER_LOC_MATRIX_MODEL] =
+        GetShaderLocationAttrib(m_shader, "instanceTransform");
+    return true;
+}
+
+void InstancedRenderer::Begin() {
+    for (int i = 0; i < m_batchCount; i++) {
+        m_batches[i].transforms.clear();
+    }
+    m_batchIndex.clear();
+    m_batchCount = 0;
+    m_stats = InstancingStats();
+}
+
+void InstancedRenderer::Add(const Mesh& mesh, const Material& material,
+                            const Matrix& transform) {
+    const BatchKey key = {mesh.vaoId, mesh.vboId ? mesh.vboId[0] : 0,
+                          material.shader.id,
+                          material.maps
+                              ? material.maps[MATERIAL_MAP_DIFFUSE].texture.id
+                              : 0};
+    auto inserted = m_batchIndex.insert(std::make_pair(key, m_batchCount));
+    if (inserted.second) {
+        if (m_batchCount == (int)m_batches.size())
+            m_batches.emplace_back();
+        Batch& batch = m_batches[m_batchCount++];
+        batch.mesh = mesh;
+        batch.material = material;
+    }
+    m_batches[inserted.first->second].transforms.push_back(transform);
+    m_stats.instances++;
+    m_stats.batches = m_batchCount;
+}
+
+void InstancedRenderer::AddModel(const Model& model, const Matrix& transform) {
+    for (int i = 0; i < model.meshCount; i++) {
+        Add(model.meshes[i], model.materials[model.meshMaterial[i]],
+            transform);
+    }
+}
+
+int InstancedRenderer::Draw() {
+    for (int i = 0; i < m_batchCount; i++) {
+        Batch& batch = m_batches[i];
+        const int count = (int)batch.transforms.size();
+        if (count >= m_minInstances && m_shader.id > 0) {
+            // Same textures and colour, drawn through the instancing shader
+            Material material = batch.material;
+            material.shader = m_shader;
+            DrawMeshInstanced(batch.mesh, material, batch.transforms.data(),
+                              count);
+            m_stats.instancedBatches++;
+            m_stats.drawCalls++;
+        } else {
+            for (const Matrix& transform : batch.transforms) {
+                DrawMesh(batch.mesh, batch.material, transform);
+                m_stats.drawCalls++;
+            }
+        }
+    }
+    return m_stats.drawCalls;
+}
+
+}  // namespace arena
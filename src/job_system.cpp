@@ -0,0 +1,90 @@
+#include "job_system.h"
+#include <algorithm>
+#include "logger.h"
+
+namespace arena {
+
+JobSystem::JobSystem(int workerCount) {
+    if (workerCount <= 0) {
+        workerCount = std::max(1, (int)std::thread::hardware_concurrency()) - 1;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+    LOG_INFO("Job system started with ", workerCount, " worker threads");
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::ParallelFor(const int count, const int batchSize,
+                            const RangeJob& job, const int maxThreads) {
+    if (count <= 0)
+        return;
+
+    const int batch = std::max(batchSize, 1);
+    const int batches = (count + batch - 1) / batch;
+    int helpers = std::min(GetWorkerCount(), batches - 1);
+    if (maxThreads > 0)
+        helpers = std::min(helpers, maxThreads - 1);
+    if (helpers <= 0) {
+        job(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_batchSize = batch;
+        m_participants = helpers;
+        m_busy = helpers;
+        m_next.store(0);
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runBatches();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_job = nullptr;
+}
+
+void JobSystem::runBatches() {
+    int begin;
+    while ((begin = m_next.fetch_add(m_batchSize)) < m_count) {
+        (*m_job)(begin, std::min(begin + m_batchSize, m_count));
+    }
+}
+
+void JobSystem::workerLoop(const int index) {
+    unsigned int seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this, seen] {
+            return m_quit || m_generation != seen;
+        });
+        if (m_quit)
+            return;
+        seen = m_generation;
+        if (index >= m_participants)
+            continue;
+
+        lock.unlock();
+        runBatches();
+        lock.lock();
+        if (--m_busy == 0)
+            m_done.notify_one();
+    }
+}
+
+}  // namespace arena
@@ -0,0 +1,305 @@
+#include "lag_compensation.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+LagCompensator::LagCompensator(const LagCompensationSettings& settings,
+                               const TerrainSettings& terrain)
+    : m_settings(settings),
+      m_originX(-terrain.mapWidth / 2),
+      m_originZ(-terrain.mapDepth / 2) {
+    m_capacity = (int)ceilf(settings.historyDuration * settings.tickRate) + 1;
+    m_cellsX = std::max(1, (int)ceilf(terrain.mapWidth / settings.cellSize));
+    m_cellsZ = std::max(1, (int)ceilf(terrain.mapDepth / settings.cellSize));
+    m_cells.resize(m_cellsX * m_cellsZ);
+
+    // History memory is allocated once for the configured entity budget
+    m_samples.resize(settings.maxEntities * m_capacity);
+    m_entities.reserve(settings.maxEntities);
+
+    m_stats.historyCapacity = m_capacity;
+    m_stats.bytesPerEntity =
+        m_capacity * sizeof(HitboxSample) + sizeof(Entity);
+    m_stats.totalBytes = settings.maxEntities * m_stats.bytesPerEntity;
+    LOG_INFO("Lag compensation: ", m_capacity, " ticks of history, ",
+             m_stats.bytesPerEntity, " bytes per entity, ",
+             m_stats.totalBytes, " bytes reserved");
+}
+
+int LagCompensator::AddEntity() {
+    int entityId;
+    if (!m_freeEntities.empty()) {
+        entityId = m_freeEntities.back();
+        m_freeEntities.pop_back();
+    } else if ((int)m_entities.size() < m_settings.maxEntities) {
+        entityId = (int)m_entities.size();
+        m_entities.push_back(Entity());
+    } else {
+        LOG_ERROR("Lag compensation entity limit reached: ",
+                  m_settings.maxEntities);
+        return -1;
+    }
+
+    m_entities[entityId] = Entity();
+    m_entities[entityId].active = true;
+    for (int slot = 0; slot < m_capacity; slot++) {
+        sampleAt(entityId, slot) = HitboxSample();
+    }
+    m_stats.entityCount++;
+    return entityId;
+}
+
+void LagCompensator::RemoveEntity(const int entityId) {
+    if (entityId < 0 || entityId >= (int)m_entities.size() ||
+        !m_entities[entityId].active) {
+        return;
+    }
+
+    linkCells(entityId, false);
+    m_entities[entityId].active = false;
+    m_freeEntities.push_back(entityId);
+    m_stats.entityCount--;
+}
+
+void LagCompensator::BeginTick(const int tick) {
+    m_currentTick = tick;
+}
+
+int LagCompensator::GetOldestTick() const {
+    return std::max(0, m_currentTick - m_capacity + 1);
+}
+
+void LagCompensator::Record(const int entityId, const PlayerState& state) {
+    if (entityId < 0 || m_currentTick < 0)
+        return;
+
+    HitboxSample& sample = sampleAt(entityId, m_currentTick % m_capacity);
+    sample.position = state.position;
+    sample.radius = state.radius;
+    sample.height = state.height;
+    sample.tick = m_currentTick;
+
+    updateBroadphase(entityId);
+}
+
+void LagCompensator::linkCells(const int entityId, const bool link) {
+    const Entity& entity = m_entities[entityId];
+    for (int z = entity.minCellZ; z <= entity.maxCellZ; z++) {
+        for (int x = entity.minCellX; x <= entity.maxCellX; x++) {
+            std::vector<int>& cell = m_cells[z * m_cellsX + x];
+            if (link) {
+                cell.push_back(entityId);
+            } else {
+                cell.erase(std::find(cell.begin(), cell.end(), entityId));
+            }
+        }
+    }
+}
+
+void LagCompensator::updateBroadphase(const int entityId) {
+    // Bounds of the whole rewindable history
+    float minX = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxZ = -FLT_MAX;
+    const int oldestTick = GetOldestTick();
+    for (int slot = 0; slot < m_capacity; slot++) {
+        const HitboxSample& sample = sampleAt(entityId, slot);
+        if (sample.tick < oldestTick)
+            continue;
+        minX = std::min(minX, sample.position.x - sample.radius);
+        maxX = std::max(maxX, sample.position.x + sample.radius);
+        minZ = std::min(minZ, sample.position.z - sample.radius);
+        maxZ = std::max(maxZ, sample.position.z + sample.radius);
+    }
+
+    auto toCell = [](float value, float origin, float size, int count) {
+        int cell = (int)floorf((value - origin) / size);
+        return std::min(std::max(cell, 0), count - 1);
+    };
+
+    Entity& entity = m_entities[entityId];
+    int cellMinX = toCell(minX, m_originX, m_settings.cellSize, m_cellsX);
+    int cellMaxX = toCell(maxX, m_originX, m_settings.cellSize, m_cellsX);
+    int cellMinZ = toCell(minZ, m_originZ, m_settings.cellSize, m_cellsZ);
+    int cellMaxZ = toCell(maxZ, m_originZ, m_settings.cellSize, m_cellsZ);
+
+    // Entities rarely leave their cells within the history window, so the
+    // grid is only touched when the covered range changes
+    if (cellMinX == entity.minCellX && cellMaxX == entity.maxCellX &&
+        cellMinZ == entity.minCellZ && cellMaxZ == entity.maxCellZ) {
+        return;
+    }
+
+    linkCells(entityId, false);
+    entity.minCellX = cellMinX;
+    entity.maxCellX = cellMaxX;
+    entity.minCellZ = cellMinZ;
+    entity.maxCellZ = cellMaxZ;
+    linkCells(entityId, true);
+}
+
+bool LagCompensator::GetSample(const int entityId, const float tick,
+                               HitboxSample& outSample) const {
+    if (entityId < 0 || entityId >= (int)m_entities.size() ||
+        !m_entities[entityId].active || m_currentTick < 0) {
+        return false;
+    }
+
+    float clampedTick = utils::Clamp(tick, (float)GetOldestTick(),
+                                     (float)m_currentTick);
+    int tick0 = (int)floorf(clampedTick);
+    int tick1 = std::min(tick0 + 1, m_currentTick);
+    float alpha = clampedTick - tick0;
+
+    const HitboxSample& s0 = sampleAt(entityId, tick0 % m_capacity);
+    const HitboxSample& s1 = sampleAt(entityId, tick1 % m_capacity);
+    if (s0.tick != tick0)
+        return false;
+
+    outSample = s0;
+    if (s1.tick == tick1 && alpha > 0.0f) {
+        outSample.position = Vector3Lerp(s0.position, s1.position, alpha);
+        outSample.radius = Lerp(s0.radius, s1.radius, alpha);
+        outSample.height = Lerp(s0.height, s1.height, alpha);
+    }
+    return true;
+}
+
+bool LagCompensator::testCell(const int cellX, const int cellZ,
+                              const Ray& ray, const float maxDistance,
+                              const float tick, const int ignoreEntity,
+                              RewindHit& outHit) {
+    bool hit = false;
+    for (int entityId : m_cells[cellZ * m_cellsX + cellX]) {
+        Entity& entity = m_entities[entityId];
+        if (entity.queryStamp == m_queryStamp || entityId == ignoreEntity)
+            continue;
+        entity.queryStamp = m_queryStamp;
+        m_stats.candidatesTested++;
+
+        HitboxSample sample;
+        if (!GetSample(entityId, tick, sample))
+            continue;
+
+        // Characters are upright capsules around their center position
+        float halfSegment = std::max(sample.height / 2 - sample.radius, 0.0f);
+        Vector3 a = {sample.position.x, sample.position.y - halfSegment,
+                     sample.position.z};
+        Vector3 b = {sample.position.x, sample.position.y + halfSegment,
+                     sample.position.z};
+
+        RayCollision collision;
+        if (utils::GetRayCollisionCapsule(ray, a, b, sample.radius,
+                                          collision) &&
+            collision.distance <= maxDistance &&
+            (outHit.entityId == -1 || collision.distance < outHit.distance)) {
+            outHit.entityId = entityId;
+            outHit.distance = collision.distance;
+            outHit.point = collision.point;
+            outHit.normal = collision.normal;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+bool LagCompensator::Raycast(const Ray& ray, const float maxDistance,
+                             const float tick, const int ignoreEntity,
+                             RewindHit& outHit) {
+    utils::Stopwatch timer;
+    outHit = RewindHit();
+    m_queryStamp++;
+
+    // Clip the ray against the grid bounds on the XZ plane
+    const float gridMin[2] = {m_originX, m_originZ};
+    const float gridMax[2] = {m_originX + m_cellsX * m_settings.cellSize,
+                              m_originZ + m_cellsZ * m_settings.cellSize};
+    const float origin[2] = {ray.position.x, ray.position.z};
+    const float direction[2] = {ray.direction.x, ray.direction.z};
+    float tEnter = 0.0f;
+    float tExit = maxDistance;
+    for (int axis = 0; axis < 2; axis++) {
+        if (fabsf(direction[axis]) < 1e-8f) {
+            if (origin[axis] < gridMin[axis] || origin[axis] > gridMax[axis])
+                tExit = -1.0f;
+            continue;
+        }
+        float t0 = (gridMin[axis] - origin[axis]) / direction[axis];
+        float t1 = (gridMax[axis] - origin[axis]) / direction[axis];
+        tEnter = std::max(tEnter, std::min(t0, t1));
+        tExit = std::min(tExit, std::max(t0, t1));
+    }
+
+    if (tEnter <= tExit) {
+        // Walk the cells along the ray (Amanatides & Woo)
+        float startX = origin[0] + direction[0] * tEnter;
+        float startZ = origin[1] + direction[1] * tEnter;
+        int cellX = std::min(
+            std::max((int)floorf((startX - m_originX) / m_settings.cellSize),
+                     0),
+            m_cellsX - 1);
+        int cellZ = std::min(
+            std::max((int)floorf((startZ - m_originZ) / m_settings.cellSize),
+                     0),
+            m_cellsZ - 1);
+
+        int stepX = direction[0] > 0 ? 1 : -1;
+        int stepZ = direction[1] > 0 ? 1 : -1;
+        float deltaX = fabsf(direction[0]) < 1e-8f
+                           ? FLT_MAX
+                           : m_settings.cellSize / fabsf(direction[0]);
+        float deltaZ = fabsf(direction[1]) < 1e-8f
+                           ? FLT_MAX
+                           : m_settings.cellSize / fabsf(direction[1]);
+        float boundaryX =
+            m_originX + (cellX + (stepX > 0 ? 1 : 0)) * m_settings.cellSize;
+        float boundaryZ =
+            m_originZ + (cellZ + (stepZ > 0 ? 1 : 0)) * m_settings.cellSize;
+        float nextX = deltaX == FLT_MAX
+                          ? FLT_MAX
+                          : (boundaryX - origin[0]) / direction[0];
+        float nextZ = deltaZ == FLT_MAX
+                          ? FLT_MAX
+                          : (boundaryZ - origin[1]) / direction[1];
+
+        while (true) {
+            testCell(cellX, cellZ, ray, maxDistance, tick, ignoreEntity,
+                     outHit);
+
+            // Any closer hit would have been inside a cell already visited
+            float cellExit = std::min(nextX, nextZ);
+            if (outHit.entityId != -1 && outHit.distance <= cellExit)
+                break;
+            if (cellExit > tExit)
+                break;
+
+            if (nextX < nextZ) {
+                cellX += stepX;
+                nextX += deltaX;
+            } else {
+                cellZ += stepZ;
+                nextZ += deltaZ;
+            }
+            if (cellX < 0 || cellX >= m_cellsX || cellZ < 0 ||
+                cellZ >= m_cellsZ) {
+                break;
+            }
+        }
+    }
+
+    double elapsed = timer.ElapsedMs();
+    m_stats.queries++;
+    m_stats.lastQueryMs = elapsed;
+    m_stats.maxQueryMs = std::max(m_stats.maxQueryMs, elapsed);
+    return outHit.entityId != -1;
+}
+
+void LagCompensator::ResetFrameStats() {
+    m_stats.queries = 0;
+    m_stats.candidatesTested = 0;
+}
+
+}  // namespace arena
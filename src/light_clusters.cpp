@@ -0,0 +1,320 @@
+#include "light_clusters.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "logger.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "utils.h"
+
+// ARENA_CLUSTERS_NO_SSE forces the scalar path, the tests build both
+#if !defined(ARENA_CLUSTERS_NO_SSE) && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ARENA_CLUSTERS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace arena {
+
+static const int GROUP_SIZE = 4;
+static const int INDEX_ROW = 1024;  // Light indices per texture row
+
+// Texture units above the ones raylib binds material maps and batch
+// textures to, so draws in between leave them bound
+static const int TABLE_UNIT = 8;
+static const int INDEX_UNIT = 9;
+static const int LIGHT_UNIT = 10;
+
+LightClusters::LightClusters(const LightingSettings& settings)
+    : m_settings(settings),
+      m_tilesPerSlice(settings.clusterTilesX * settings.clusterTilesY),
+      m_sliceStride((m_tilesPerSlice + GROUP_SIZE - 1) / GROUP_SIZE *
+                    GROUP_SIZE),
+      m_sliceScale(settings.clusterSlices /
+                   logf(settings.clusterFar / settings.clusterNear)),
+      m_view(MatrixIdentity()) {
+    const int clusters = m_tilesPerSlice * settings.clusterSlices;
+    m_lightCounts.resize(clusters);
+    m_offsets.resize(clusters);
+    m_hits.resize(m_sliceStride);
+}
+
+LightClusters::~LightClusters() {
+    if (m_tableTexture > 0)
+        rlUnloadTexture(m_tableTexture);
+    if (m_indexTexture > 0)
+        rlUnloadTexture(m_indexTexture);
+    if (m_lightTexture > 0)
+        rlUnloadTexture(m_lightTexture);
+}
+
+int LightClusters::GetSlice(const float depth) const {
+    if (depth <= m_settings.clusterNear)
+        return 0;
+    const int slice =
+        (int)(logf(depth / m_settings.clusterNear) * m_sliceScale);
+    return std::min(slice, m_settings.clusterSlices - 1);
+}
+
+void LightClusters::computeBounds(const float fovy, const float aspect) {
+    m_fovy = fovy;
+    m_aspect = aspect;
+    const int size = m_sliceStride * m_settings.clusterSlices;
+    // Padding lanes can never touch a sphere
+    const float inf = std::numeric_limits<float>::infinity();
+    m_bounds.minX.assign(size, inf);
+    m_bounds.minY.assign(size, inf);
+    m_bounds.minZ.assign(size, inf);
+    m_bounds.maxX.assign(size, -inf);
+    m_bounds.maxY.assign(size, -inf);
+    m_bounds.maxZ.assign(size, -inf);
+
+    // A tile's edges are lines through the eye, so its view-space box in
+    // a slice is spanned by the edges at the slice's near and far depth
+    const float tanY = tanf(fovy * 0.5f * DEG2RAD);
+    const float tanX = tanY * aspect;
+    const float ratio = m_settings.clusterFar / m_settings.clusterNear;
+    for (int slice = 0; slice < m_settings.clusterSlices; slice++) {
+        const float nearDepth =
+            m_settings.clusterNear *
+            powf(ratio, (float)slice / m_settings.clusterSlices);
+        const float farDepth =
+            m_settings.clusterNear *
+            powf(ratio, (float)(slice + 1) / m_settings.clusterSlices);
+        for (int y = 0; y < m_settings.clusterTilesY; y++) {
+            const float bottom = -1.0f + 2.0f * y / m_settings.clusterTilesY;
+            const float top =
+                -1.0f + 2.0f * (y + 1) / m_settings.clusterTilesY;
+            for (int x = 0; x < m_settings.clusterTilesX; x++) {
+                const float left = -1.0f + 2.0f * x / m_settings.clusterTilesX;
+                const float right =
+                    -1.0f + 2.0f * (x + 1) / m_settings.clusterTilesX;
+                const int i =
+                    slice * m_sliceStride + y * m_settings.clusterTilesX + x;
+                m_bounds.minX[i] = std::min(left * tanX * nearDepth,
+                                            left * tanX * farDepth);
+                m_bounds.maxX[i] = std::max(right * tanX * nearDepth,
+                                            right * tanX * farDepth);
+                m_bounds.minY[i] = std::min(bottom * tanY * nearDepth,
+                                            bottom * tanY * farDepth);
+                m_bounds.maxY[i] = std::max(top * tanY * nearDepth,
+                                            top * tanY * farDepth);
+                m_bounds.minZ[i] = nearDepth;
+                m_bounds.maxZ[i] = farDepth;
+            }
+        }
+    }
+}
+
+void LightClusters::Build(const std::vector<PointLight>& lights,
+                          const Camera3D& camera, const float aspect) {
+    utils::Stopwatch timer;
+    m_stats = LightClusterStats();
+    if (camera.fovy != m_fovy || aspect != m_aspect)
+        computeBounds(camera.fovy, aspect);
+
+    m_view = MatrixLookAt(camera.position, camera.target, camera.up);
+    std::fill(m_lightCounts.begin(), m_lightCounts.end(), 0);
+    m_pairs.clear();
+
+    const int count =
+        std::min((int)lights.size(), m_settings.maxPointLights);
+    m_stats.lights = (int)lights.size();
+    for (int i = 0; i < count; i++) {
+        // The view looks down -z, depth is positive into the view
+        Vector3 center = Vector3Transform(lights[i].position, m_view);
+        center.z = -center.z;
+        const int before = m_stats.assignments;
+        assignLight(i, center, lights[i].radius);
+        if (m_stats.assignments > before)
+            m_stats.visibleLights++;
+    }
+
+    // Group the pairs by cluster with a counting sort
+    int offset = 0;
+    for (size_t cluster = 0; cluster < m_lightCounts.size(); cluster++) {
+        m_offsets[cluster] = offset;
+        offset += m_lightCounts[cluster];
+        m_stats.maxClusterLights =
+            std::max(m_stats.maxClusterLights, m_lightCounts[cluster]);
+    }
+    m_indices.resize(offset);
+    for (size_t i = 0; i < m_pairs.size(); i += 2) {
+        m_indices[m_offsets[m_pairs[i]]++] = m_pairs[i + 1];
+    }
+    for (size_t cluster = 0; cluster < m_lightCounts.size(); cluster++) {
+        m_offsets[cluster] -= m_lightCounts[cluster];
+    }
+    m_stats.buildTimeMs = timer.ElapsedMs();
+}
+
+void LightClusters::assignLight(const int light, const Vector3& center,
+                                const float radius) {
+    if (center.z + radius < m_settings.clusterNear ||
+        center.z - radius > m_settings.clusterFar)
+        return;
+
+    // Only the slices the sphere's depth range covers are tested
+    const int firstSlice = GetSlice(center.z - radius);
+    const int lastSlice = GetSlice(center.z + radius);
+    const float radiusSq = radius * radius;
+    for (int slice = firstSlice; slice <= lastSlice; slice++) {
+        const int base = slice * m_sliceStride;
+        m_stats.testedClusters += m_tilesPerSlice;
+        // Squared distance from the sphere centre to each box
+#ifdef ARENA_CLUSTERS_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 cx = _mm_set1_ps(center.x);
+        const __m128 cy = _mm_set1_ps(center.y);
+        const __m128 cz = _mm_set1_ps(center.z);
+        const __m128 r2 = _mm_set1_ps(radiusSq);
+        for (int i = 0; i < m_sliceStride; i += GROUP_SIZE) {
+            const int b = base + i;
+            const __m128 dx = _mm_max_ps(
+                zero,
+                _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_bounds.minX[b]), cx),
+                           _mm_sub_ps(cx, _mm_loadu_ps(&m_bounds.maxX[b]))));
+            const __m128 dy = _mm_max_ps(
+                zero,
+                _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_bounds.minY[b]), cy),
+                           _mm_sub_ps(cy, _mm_loadu_ps(&m_bounds.maxY[b]))));
+            const __m128 dz = _mm_max_ps(
+                zero,
+                _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_bounds.minZ[b]), cz),
+                           _mm_sub_ps(cz, _mm_loadu_ps(&m_bounds.maxZ[b]))));
+            const __m128 distanceSq = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                _mm_mul_ps(dz, dz));
+            const int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSq, r2));
+            for (int lane = 0; lane < GROUP_SIZE; lane++) {
+                m_hits[i + lane] = (mask >> lane) & 1;
+            }
+        }
+#else
+        for (int i = 0; i < m_sliceStride; i++) {
+            const int b = base + i;
+            const float dx =
+                std::max(0.0f, std::max(m_bounds.minX[b] - center.x,
+                                        center.x - m_bounds.maxX[b]));
+            const float dy =
+                std::max(0.0f, std::max(m_bounds.minY[b] - center.y,
+                                        center.y - m_bounds.maxY[b]));
+            const float dz =
+                std::max(0.0f, std::max(m_bounds.minZ[b] - center.z,
+                                        center.z - m_bounds.maxZ[b]));
+            m_hits[i] = dx * dx + dy * dy + dz * dz <= radiusSq;
+        }
+#endif
+        for (int tile = 0; tile < m_tilesPerSlice; tile++) {
+            if (!m_hits[tile])
+                continue;
+            if ((int)m_pairs.size() / 2 >= m_settings.maxLightIndices) {
+                m_stats.droppedAssignments++;
+                continue;
+            }
+            const int cluster = slice * m_tilesPerSlice + tile;
+            m_pairs.push_back(cluster);
+            m_pairs.push_back(light);
+            m_lightCounts[cluster]++;
+            m_stats.assignments++;
+        }
+    }
+}
+
+bool LightClusters::Load(const Shader& shader) {
+    m_shader = shader;
+    m_indexRows = (m_settings.maxLightIndices + INDEX_ROW - 1) / INDEX_ROW;
+    m_tableData.assign(GetClusterCount() * 3, 0.0f);
+    m_indexData.assign(m_indexRows * INDEX_ROW, 0.0f);
+    m_lightData.assign(m_settings.maxPointLights * 2 * 4, 0.0f);
+
+    m_tableTexture = rlLoadTexture(m_tableData.data(), m_tilesPerSlice,
+                                   m_settings.clusterSlices,
+                                   PIXELFORMAT_UNCOMPRESSED_R32G32B32, 1);
+    m_indexTexture =
+        rlLoadTexture(m_indexData.data(), INDEX_ROW, m_indexRows,
+                      PIXELFORMAT_UNCOMPRESSED_R32, 1);
+    m_lightTexture = rlLoadTexture(m_lightData.data(),
+                                   m_settings.maxPointLights, 2,
+                                   PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1);
+    if (m_tableTexture == 0 || m_indexTexture == 0 || m_lightTexture == 0) {
+        LOG_ERROR("Failed to create light cluster buffers");
+        return false;
+    }
+
+    const int units[3] = {TABLE_UNIT, INDEX_UNIT, LIGHT_UNIT};
+    SetShaderValue(shader, GetShaderLocation(shader, "clusterTable"),
+                   &units[0], SHADER_UNIFORM_INT);
+    SetShaderValue(shader, GetShaderLocation(shader, "clusterIndices"),
+                   &units[1], SHADER_UNIFORM_INT);
+    SetShaderValue(shader, GetShaderLocation(shader, "clusterLights"),
+                   &units[2], SHADER_UNIFORM_INT);
+    m_viewLoc = GetShaderLocation(shader, "clusterView");
+    m_gridLoc = GetShaderLocation(shader, "clusterGrid");
+    m_depthLoc = GetShaderLocation(shader, "clusterDepth");
+    if (m_viewLoc == -1 || m_gridLoc == -1 || m_depthLoc == -1) {
+        LOG_WARNING("Some light cluster uniforms were not found");
+    }
+    return true;
+}
+
+void LightClusters::Upload(const std::vector<PointLight>& lights,
+                           const int screenWidth, const int screenHeight) {
+    if (m_tableTexture == 0)
+        return;
+
+    for (int cluster = 0; cluster < GetClusterCount(); cluster++) {
+        m_tableData[cluster * 3] = (float)m_offsets[cluster];
+        m_tableData[cluster * 3 + 1] = (float)m_lightCounts[cluster];
+    }
+    std::copy(m_indices.begin(), m_indices.end(), m_indexData.begin());
+    const int count =
+        std::min((int)lights.size(), m_settings.maxPointLights);
+    float* positions = m_lightData.data();
+    float* colors = positions + m_settings.maxPointLights * 4;
+    for (int i = 0; i < count; i++) {
+        const PointLight& light = lights[i];
+        positions[i * 4] = light.position.x;
+        positions[i * 4 + 1] = light.position.y;
+        positions[i * 4 + 2] = light.position.z;
+        positions[i * 4 + 3] = light.radius;
+        const Vector4 color = ColorNormalize(light.color);
+        colors[i * 4] = color.x * light.intensity;
+        colors[i * 4 + 1] = color.y * light.intensity;
+        colors[i * 4 + 2] = color.z * light.intensity;
+    }
+
+    // Only the rows holding this frame's indices are sent
+    const int rows = std::max(1, ((int)m_indices.size() + INDEX_ROW - 1) /
+                                     INDEX_ROW);
+    rlUpdateTexture(m_tableTexture, 0, 0, m_tilesPerSlice,
+                    m_settings.clusterSlices,
+                    PIXELFORMAT_UNCOMPRESSED_R32G32B32, m_tableData.data());
+    rlUpdateTexture(m_indexTexture, 0, 0, INDEX_ROW, rows,
+                    PIXELFORMAT_UNCOMPRESSED_R32, m_indexData.data());
+    rlUpdateTexture(m_lightTexture, 0, 0, m_settings.maxPointLights, 2,
+                    PIXELFORMAT_UNCOMPRESSED_R32G32B32A32,
+                    m_lightData.data());
+
+    rlActiveTextureSlot(TABLE_UNIT);
+    rlEnableTexture(m_tableTexture);
+    rlActiveTextureSlot(INDEX_UNIT);
+    rlEnableTexture(m_indexTexture);
+    rlActiveTextureSlot(LIGHT_UNIT);
+    rlEnableTexture(m_lightTexture);
+    rlActiveTextureSlot(0);
+
+    SetShaderValueMatrix(m_shader, m_viewLoc, m_view);
+    const float grid[4] = {
+        (float)m_settings.clusterTilesX, (float)m_settings.clusterTilesY,
+        (float)screenWidth / m_settings.clusterTilesX,
+        (float)screenHeight / m_settings.clusterTilesY};
+    SetShaderValue(m_shader, m_gridLoc, grid, SHADER_UNIFORM_VEC4);
+    const float depth[4] = {m_settings.clusterNear, m_settings.clusterFar,
+                            m_sliceScale,
+                            logf(m_settings.clusterNear) * m_sliceScale};
+    SetShaderValue(m_shader, m_depthLoc, depth, SHADER_UNIFORM_VEC4);
+}
+
+}  // namespace arena
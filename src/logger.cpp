@@ -9,6 +9,7 @@ LogLevel Logger::currentLevel = LogLevel::INFO;
 std::ofstream Logger::logFile;
 bool Logger::useFile = false;
 bool Logger::isInitialized = false;
+std::mutex Logger::mutex;
 
 void Logger::Init(LogLevel level, const std::string& filename) {
     currentLevel = level;
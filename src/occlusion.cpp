@@ -0,0 +1,296 @@
+#include "occlusion.h"
+#include <algorithm>
+#include <cmath>
+#include "logger.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "utils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ARENA_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace arena {
+
+// Geometry closer than this is clipped before rasterization
+static const float NEAR_W = RL_CULL_DISTANCE_NEAR;
+
+static Vector4 transformPoint(const Matrix& m, const Vector3& p) {
+    return Vector4{m.m0 * p.x + m.m4 * p.y + m.m8 * p.z + m.m12,
+                   m.m1 * p.x + m.m5 * p.y + m.m9 * p.z + m.m13,
+                   m.m2 * p.x + m.m6 * p.y + m.m10 * p.z + m.m14,
+                   m.m3 * p.x + m.m7 * p.y + m.m11 * p.z + m.m15};
+}
+
+OcclusionCuller::OcclusionCuller(const OcclusionSettings& settings)
+    : m_settings(settings), m_viewProjection(MatrixIdentity()) {
+    // Whole tiles, and rows that split into groups of four pixels
+    const int tileSize = std::max(settings.tileSize, 4) / 4 * 4;
+    m_tilesX = std::max(1, (settings.bufferWidth + tileSize - 1) / tileSize);
+    m_tilesY = std::max(1, (settings.bufferHeight + tileSize - 1) / tileSize);
+    m_width = m_tilesX * tileSize;
+    m_height = m_tilesY * tileSize;
+    m_depth.assign(m_width * m_height, 0.0f);
+    m_tiles.assign(m_tilesX * m_tilesY, 0.0f);
+}
+
+void OcclusionCuller::SetOccluders(const std::vector<Vector3>& triangles) {
+    m_occluders.clear();
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+        Vector3 edge1 = Vector3Subtract(triangles[i + 1], triangles[i]);
+        Vector3 edge2 = Vector3Subtract(triangles[i + 2], triangles[i]);
+        float area = Vector3Length(Vector3CrossProduct(edge1, edge2)) * 0.5f;
+        if (area < m_settings.minOccluderArea)
+            continue;
+        m_occluders.insert(m_occluders.end(), triangles.begin() + i,
+                           triangles.begin() + i + 3);
+    }
+    m_stats.occluderTriangles = (int)m_occluders.size() / 3;
+    LOG_INFO("Occlusion: ", m_stats.occluderTriangles, " of ",
+             triangles.size() / 3, " terrain triangles used as occluders");
+}
+
+void OcclusionCuller::Render(const Matrix& viewProjection) {
+    utils::Stopwatch timer;
+    m_viewProjection = viewProjection;
+    m_stats.rasterizedTriangles = 0;
+    m_stats.testedBoxes = 0;
+    m_stats.occludedBoxes = 0;
+    m_stats.testTimeMs = 0.0f;
+    std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+
+    Vector4 clip[3];
+    for (size_t i = 0; i < m_occluders.size(); i += 3) {
+        for (int v = 0; v < 3; v++) {
+            clip[v] = transformPoint(viewProjection, m_occluders[i + v]);
+        }
+        rasterizeTriangle(clip);
+    }
+    buildTiles();
+    m_stats.rasterTimeMs = timer.ElapsedMs();
+}
+
+void OcclusionCuller::rasterizeTriangle(const Vector4* clip) {
+    // Trivially reject triangles entirely outside one clip plane
+    for (int axis = 0; axis < 2; axis++) {
+        bool below = true;
+        bool above = true;
+        for (int v = 0; v < 3; v++) {
+            float c = axis == 0 ? clip[v].x : clip[v].y;
+            below &= c < -clip[v].w;
+            above &= c > clip[v].w;
+        }
+        if (below || above)
+            return;
+    }
+
+    // Clip against the near plane; a triangle becomes at most a quad
+    Vector4 polygon[4];
+    int count = 0;
+    for (int v = 0; v < 3; v++) {
+        const Vector4& a = clip[v];
+        const Vector4& b = clip[(v + 1) % 3];
+        const bool aInside = a.w >= NEAR_W;
+        const bool bInside = b.w >= NEAR_W;
+        if (aInside)
+            polygon[count++] = a;
+        if (aInside != bInside) {
+            float t = (NEAR_W - a.w) / (b.w - a.w);
+            polygon[count++] = Vector4{a.x + (b.x - a.x) * t,
+                                       a.y + (b.y - a.y) * t,
+                                       a.z + (b.z - a.z) * t, NEAR_W};
+        }
+    }
+    if (count < 3)
+        return;
+
+    ScreenVertex screen[4];
+    for (int v = 0; v < count; v++) {
+        const float invW = 1.0f / polygon[v].w;
+        screen[v].x = (polygon[v].x * invW * 0.5f + 0.5f) * m_width;
+        screen[v].y = (0.5f - polygon[v].y * invW * 0.5f) * m_height;
+        screen[v].depth = invW;
+    }
+    m_stats.rasterizedTriangles++;
+    fillTriangle(screen[0], screen[1], screen[2]);
+    if (count == 4)
+        fillTriangle(screen[0], screen[2], screen[3]);
+}
+
+void OcclusionCuller::fillTriangle(const ScreenVertex& v0,
+                                   const ScreenVertex& a,
+                                   const ScreenVertex& b) {
+    // Wind counter-clockwise in screen space so covered pixels have all
+    // three edge functions positive
+    float area = (a.x - v0.x) * (b.y - v0.y) - (a.y - v0.y) * (b.x - v0.x);
+    if (fabsf(area) < 1e-6f)
+        return;
+    const ScreenVertex& v1 = area > 0.0f ? a : b;
+    const ScreenVertex& v2 = area > 0.0f ? b : a;
+    area = fabsf(area);
+
+    // Pixel bounds, with x aligned to groups of four
+    int minX = std::max(0, (int)floorf(std::min({v0.x, v1.x, v2.x})));
+    int maxX = std::min(m_width - 1, (int)ceilf(std::max({v0.x, v1.x, v2.x})));
+    int minY = std::max(0, (int)floorf(std::min({v0.y, v1.y, v2.y})));
+    int maxY =
+        std::min(m_height - 1, (int)ceilf(std::max({v0.y, v1.y, v2.y})));
+    if (minX > maxX || minY > maxY)
+        return;
+    minX &= ~3;
+
+    // Edge function of the edge opposite each vertex: e = A * x + B * y + C
+    const float a0 = v1.y - v2.y, b0 = v2.x - v1.x;
+    const float a1 = v2.y - v0.y, b1 = v0.x - v2.x;
+    const float a2 = v0.y - v1.y, b2 = v1.x - v0.x;
+    const float c0 = -(a0 * v1.x + b0 * v1.y);
+    const float c1 = -(a1 * v2.x + b1 * v2.y);
+    const float c2 = -(a2 * v0.x + b2 * v0.y);
+    const float invArea = 1.0f / area;
+    const float z0 = v0.depth * invArea;
+    const float z1 = v1.depth * invArea;
+    const float z2 = v2.depth * invArea;
+
+    // Occluders must not claim more than they cover: a pixel is written
+    // only when its whole square is inside, with the farthest depth the
+    // triangle reaches within it
+    const float t0 = 0.5f * (fabsf(a0) + fabsf(b0));
+    const float t1 = 0.5f * (fabsf(a1) + fabsf(b1));
+    const float t2 = 0.5f * (fabsf(a2) + fabsf(b2));
+    const float depthBias =
+        0.5f * (fabsf(a0 * z0 + a1 * z1 + a2 * z2) +
+                fabsf(b0 * z0 + b1 * z1 + b2 * z2));
+
+    for (int y = minY; y <= maxY; y++) {
+        const float py = y + 0.5f;
+        float* row = &m_depth[y * m_width];
+#ifdef ARENA_OCCLUSION_SSE
+        const __m128 inner0 = _mm_set1_ps(t0);
+        const __m128 inner1 = _mm_set1_ps(t1);
+        const __m128 inner2 = _mm_set1_ps(t2);
+        const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        const __m128 stepE0 = _mm_set1_ps(a0);
+        const __m128 stepE1 = _mm_set1_ps(a1);
+        const __m128 stepE2 = _mm_set1_ps(a2);
+        const __m128 rowE0 = _mm_set1_ps(b0 * py + c0);
+        const __m128 rowE1 = _mm_set1_ps(b1 * py + c1);
+        const __m128 rowE2 = _mm_set1_ps(b2 * py + c2);
+        for (int x = minX; x <= maxX; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(stepE0, px), rowE0);
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(stepE1, px), rowE1);
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(stepE2, px), rowE2);
+            const __m128 inside =
+                _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, inner0),
+                                      _mm_cmpge_ps(e1, inner1)),
+                           _mm_cmpge_ps(e2, inner2));
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+            const __m128 depth = _mm_sub_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0, _mm_set1_ps(z0)),
+                                      _mm_mul_ps(e1, _mm_set1_ps(z1))),
+                           _mm_mul_ps(e2, _mm_set1_ps(z2))),
+                _mm_set1_ps(depthBias));
+            const __m128 current = _mm_loadu_ps(row + x);
+            const __m128 nearest = _mm_max_ps(current, depth);
+            _mm_storeu_ps(row + x,
+                          _mm_or_ps(_mm_and_ps(inside, nearest),
+                                    _mm_andnot_ps(inside, current)));
+        }
+#else
+        for (int x = minX; x <= maxX; x++) {
+            const float px = x + 0.5f;
+            const float e0 = a0 * px + b0 * py + c0;
+            const float e1 = a1 * px + b1 * py + c1;
+            const float e2 = a2 * px + b2 * py + c2;
+            if (e0 < t0 || e1 < t1 || e2 < t2)
+                continue;
+            row[x] = std::max(row[x],
+                              e0 * z0 + e1 * z1 + e2 * z2 - depthBias);
+        }
+#endif
+    }
+}
+
+void OcclusionCuller::buildTiles() {
+    const int tileSize = m_width / m_tilesX;
+    for (int ty = 0; ty < m_tilesY; ty++) {
+        for (int tx = 0; tx < m_tilesX; tx++) {
+            float farthest = INFINITY;
+            for (int y = ty * tileSize; y < (ty + 1) * tileSize; y++) {
+                const float* row = &m_depth[y * m_width + tx * tileSize];
+                for (int x = 0; x < tileSize; x++) {
+                    farthest = std::min(farthest, row[x]);
+                }
+            }
+            m_tiles[ty * m_tilesX + tx] = farthest;
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& box) {
+    utils::Stopwatch timer;
+    m_stats.testedBoxes++;
+
+    // Screen rectangle and nearest depth of the box corners
+    float minX = INFINITY, maxX = -INFINITY;
+    float minY = INFINITY, maxY = -INFINITY;
+    float nearest = 0.0f;
+    for (int c = 0; c < 8; c++) {
+        Vector4 clip = transformPoint(
+            m_viewProjection, Vector3{(c & 1) ? box.max.x : box.min.x,
+                                      (c & 2) ? box.max.y : box.min.y,
+                                      (c & 4) ? box.max.z : box.min.z});
+        if (clip.w < NEAR_W) {
+            // Crosses the near plane, so it covers the camera
+            m_stats.testTimeMs += timer.ElapsedMs();
+            return true;
+        }
+        const float invW = 1.0f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * m_width;
+        const float y = (0.5f - clip.y * invW * 0.5f) * m_height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::max(nearest, invW);
+    }
+
+    // Every pixel the rectangle touches, partially covered ones included
+    const int x0 = std::max(0, (int)floorf(minX));
+    const int x1 = std::min(m_width - 1, (int)floorf(maxX));
+    const int y0 = std::max(0, (int)floorf(minY));
+    const int y1 = std::min(m_height - 1, (int)floorf(maxY));
+    bool visible = x0 > x1 || y0 > y1;  // Off screen is left to the frustum
+
+    const int tileSize = m_width / m_tilesX;
+    for (int ty = y0 / tileSize; !visible && ty <= y1 / tileSize; ty++) {
+        for (int tx = x0 / tileSize; !visible && tx <= x1 / tileSize; tx++) {
+            if (m_tiles[ty * m_tilesX + tx] > nearest)
+                continue;  // Every pixel of the tile is nearer than the box
+
+            // The tile has a gap or a farther occluder; check its pixels
+            const int py0 = std::max(y0, ty * tileSize);
+            const int py1 = std::min(y1, (ty + 1) * tileSize - 1);
+            const int px0 = std::max(x0, tx * tileSize);
+            const int px1 = std::min(x1, (tx + 1) * tileSize - 1);
+            for (int y = py0; !visible && y <= py1; y++) {
+                for (int x = px0; x <= px1; x++) {
+                    if (m_depth[y * m_width + x] <= nearest) {
+                        visible = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!visible)
+        m_stats.occludedBoxes++;
+    m_stats.testTimeMs += timer.ElapsedMs();
+    return visible;
+}
+
+}  // namespace arena
@@ -0,0 +1,299 @@
+#include "player_simulation.h"
+#include <algorithm>
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+// Highest ledge a character steps onto, and steepest walkable ground
+static const float STEP_UP_HEIGHT = 0.3f;
+static const float MAX_CLIMBABLE_SLOPE = 45.0f;  // Degrees
+
+PlayerSimulation::PlayerSimulation(const Settings& settings,
+                                   const Terrain* terrain)
+    : m_settings(settings), m_terrain(terrain) {}
+
+void PlayerSimulation::calculateFacingDirection(
+    PlayerState& state, const PlayerInput& input) const {
+    // Calculate player facing direction
+    if (input.rotationDelta != 0.0f) {
+        state.facingDirection =
+            Vector3RotateByAxisAngle(state.facingDirection, Vector3{0, 1, 0},
+                                     -input.rotationDelta * DEG2RAD);
+        state.facingDirection = Vector3Normalize(state.facingDirection);
+    }
+}
+
+Vector3 PlayerSimulation::moveToFacingDirection(
+    PlayerState& state, const float delta, const Vector3& moveDirection) const {
+    // Apply movement relative to player's facing direction
+    Matrix rotationMatrix = MatrixRotateY(
+        -atan2f(state.facingDirection.z, state.facingDirection.x));
+    Vector3 relativeMove = Vector3Transform(moveDirection, rotationMatrix);
+
+    // Normalize movement direction
+    if (Vector3Length(moveDirection) > 0) {
+        float targetRotation = atan2f(relativeMove.x, relativeMove.z);
+        float rotationDiff = targetRotation - state.rotationHorizontal;
+
+        // Normalize the rotation difference to [-PI, PI]
+        if (rotationDiff > PI)
+            rotationDiff -= 2 * PI;
+        if (rotationDiff < -PI)
+            rotationDiff += 2 * PI;
+
+        // Smoothly interpolate the rotation
+        state.rotationHorizontal += rotationDiff * 10.0f * delta;
+
+        // Normalize the rotation to [0, 2*PI]
+        while (state.rotationHorizontal < 0)
+            state.rotationHorizontal += 2 * PI;
+        while (state.rotationHorizontal >= 2 * PI)
+            state.rotationHorizontal -= 2 * PI;
+    }
+
+    return relativeMove;
+}
+
+void PlayerSimulation::updateVelocity(PlayerState& state, const float delta,
+                                      const Vector3& relativeMove) const {
+    Vector3 groundNormal =
+        state.isGrounded
+            ? m_terrain->GetTriangleNormal(state.collidingTriangleIndex)
+            : Vector3{0, 1, 0};
+
+    if (state.isGrounded) {
+        // On ground, adjust velocity based on input
+        state.velocity.x = relativeMove.x * state.moveSpeed;
+        state.velocity.z = relativeMove.z * state.moveSpeed;
+
+        // Project velocity onto the ground plane
+        Vector3 velocityOnGround = Vector3Subtract(
+            state.velocity,
+            Vector3Scale(groundNormal,
+                         Vector3DotProduct(state.velocity, groundNormal)));
+        state.velocity = velocityOnGround;
+    } else {
+        // In air, apply reduced control and maintain momentum
+        float airControl = m_settings.physicsSettings.airControl;
+        float airFriction = m_settings.physicsSettings.airFriction;
+
+        state.velocity.x +=
+            relativeMove.x * state.moveSpeed * airControl * delta;
+        state.velocity.z +=
+            relativeMove.z * state.moveSpeed * airControl * delta;
+
+        state.velocity.x *= powf(airFriction, delta);
+        state.velocity.z *= powf(airFriction, delta);
+    }
+
+    // Cap horizontal velocity
+    float maxHorizontalSpeed = state.moveSpeed * 1.5f;
+    float horizontalSpeed = sqrtf(state.velocity.x * state.velocity.x +
+                                  state.velocity.z * state.velocity.z);
+    if (horizontalSpeed > maxHorizontalSpeed) {
+        float scale = maxHorizontalSpeed / horizontalSpeed;
+        state.velocity.x *= scale;
+        state.velocity.z *= scale;
+    }
+}
+
+void PlayerSimulation::Simulate(PlayerState& state, const PlayerInput& input,
+                                const float deltaTime) const {
+    const PlayerSettings& playerSettings = m_settings.playerSettings;
+
+    // Calculate player facing direction
+    calculateFacingDirection(state, input);
+
+    // Apply direction
+    Vector3 relativeMove =
+        moveToFacingDirection(state, deltaTime, input.moveDirection);
+
+    updateVelocity(state, deltaTime, relativeMove);
+
+    // Apply gravity
+    const float coyoteTime =
+        0.1f;  // Adjust this value to change the "coyote time" duration
+    if (state.timeSinceGrounded > coyoteTime) {
+        const float maxFallSpeed = -20.0f;
+        state.velocity.y += m_settings.physicsSettings.gravity * deltaTime;
+        state.velocity.y = std::max(state.velocity.y, maxFallSpeed);
+    }
+
+    // Calculate new position
+    Vector3 newPosition =
+        Vector3Add(state.position, Vector3Scale(state.velocity, deltaTime));
+
+    // Check collisions and update position
+    checkCollisions(state, newPosition, deltaTime);
+    state.position = newPosition;
+
+    // Handle jumping
+    if (input.jump && state.timeSinceGrounded <= coyoteTime) {
+        state.velocity.y = state.jumpSpeed;
+        state.isJumping = true;
+        state.isGrounded = false;
+        state.timeSinceGrounded = coyoteTime + 0.1f;  // Prevent double jumps
+    }
+
+    // Apply movement
+    state.movement = Vector3Subtract(newPosition, state.position);
+    if (Vector3Length(state.movement) > playerSettings.movementThreshold) {
+        state.position = newPosition;
+    } else if (state.isGrounded) {
+        // If grounded and movement is small, just update Y
+        state.position.y = newPosition.y;
+    }
+
+    // Clamp player position to map boundaries
+    newPosition.x =
+        utils::Clamp(newPosition.x, -m_settings.terrainSettings.mapWidth / 2,
+                     m_settings.terrainSettings.mapWidth / 2);
+    newPosition.z =
+        utils::Clamp(newPosition.z, -m_settings.terrainSettings.mapDepth / 2,
+                     m_settings.terrainSettings.mapDepth / 2);
+
+    // Calculate how much the player has moved this frame
+    if (Vector3Length(state.movement) > playerSettings.movementThreshold) {
+        state.position = newPosition;
+    } else {
+        state.movement = Vector3Zero();
+    }
+
+    // Ignore very small movements
+    if (fabs(state.velocity.y) < playerSettings.velocityThreshold) {
+        state.velocity.y = 0;
+    }
+
+    // Smooth out small fluctuations in y-position
+    if (fabs(state.position.y - state.groundHeight - state.radius) < 0.01f) {
+        state.position.y = state.groundHeight + state.radius;
+    }
+}
+
+void PlayerSimulation::checkCollisions(PlayerState& state,
+                                       Vector3& newPosition,
+                                       const float delta) const {
+    std::pair<float, int> collisionResult =
+        m_terrain->CheckCollision(newPosition, state.radius, state.height,
+                                  state.lastCollidingTriangleIndex);
+    state.groundHeight = collisionResult.first;
+    state.collidingTriangleIndex = collisionResult.second;
+
+    LOG_DEBUG("Ground height: ", state.groundHeight);
+    LOG_DEBUG("Colliding triangle index: ", state.collidingTriangleIndex);
+
+    if (state.collidingTriangleIndex != -1) {
+        std::vector<int> nearbyTriangles =
+            m_terrain->GetNearbyTriangles(newPosition, state.radius * 2);
+        Vector3 averageNormal = Vector3Zero();
+
+        if (!nearbyTriangles.empty()) {
+            for (int triangleIndex : nearbyTriangles) {
+                averageNormal = Vector3Add(
+                    averageNormal, m_terrain->GetTriangleNormal(triangleIndex));
+            }
+            averageNormal =
+                Vector3Scale(averageNormal, 1.0f / nearbyTriangles.size());
+            averageNormal = Vector3Normalize(averageNormal);
+        } else {
+            averageNormal = Vector3{
+                0, 1, 0};  // Default to upward normal if no nearby triangles
+        }
+
+        float slope = Vector3DotProduct(averageNormal, Vector3{0, 1, 0});
+        float maxClimbableSlope = cosf(DEG2RAD * MAX_CLIMBABLE_SLOPE);
+
+        float feetHeight = newPosition.y - state.height / 2;
+        float distanceToGround = feetHeight - state.groundHeight;
+
+        LOG_DEBUG("Average normal: (", averageNormal.x, ", ", averageNormal.y,
+                  ", ", averageNormal.z, ")");
+        LOG_DEBUG("Slope: ", slope);
+        LOG_DEBUG("Distance to ground: ", distanceToGround);
+
+        const float groundedTolerance = 0.1f;
+
+        if (distanceToGround <= STEP_UP_HEIGHT) {
+            if (slope > maxClimbableSlope) {
+                newPosition.y = state.groundHeight + state.height / 2;
+                if (state.velocity.y < 0)
+                    state.velocity.y = 0;
+                state.isGrounded = true;
+                state.isJumping = false;
+                state.timeSinceGrounded = 0;
+            } else {
+                Vector3 slopeDirection = Vector3Normalize(
+                    Vector3{averageNormal.x, 0, averageNormal.z});
+                float slideSpeed =
+                    Vector3Length(state.velocity) * (1.0f - slope);
+
+                Vector3 projectedVelocity = Vector3Subtract(
+                    state.velocity,
+                    Vector3Scale(
+                        averageNormal,
+                        Vector3DotProduct(state.velocity, averageNormal)));
+
+                state.velocity =
+                    Vector3Add(Vector3Scale(slopeDirection, slideSpeed),
+                               Vector3Scale(projectedVelocity, slope));
+
+                newPosition.y =
+                    state.groundHeight + state.height / 2 + groundedTolerance;
+                state.isGrounded = false;
+            }
+        } else {
+            state.isGrounded = false;
+        }
+    } else {
+        state.isGrounded = false;
+    }
+
+    if (!state.isGrounded) {
+        state.timeSinceGrounded += delta;
+    } else {
+        state.timeSinceGrounded = 0;
+    }
+
+    state.lastCollidingTriangleIndex = state.collidingTriangleIndex;
+
+    LOG_DEBUG("Final position: (", newPosition.x, ", ", newPosition.y, ", ",
+              newPosition.z, ")");
+    LOG_DEBUG("Final velocity: (", state.velocity.x, ", ", state.velocity.y,
+              ", ", state.velocity.z, ")");
+    LOG_DEBUG("Is grounded: ", state.isGrounded);
+}
+
+bool PlayerSimulation::Displace(PlayerState& state,
+                                const Vector3& offset) const {
+    if (offset.x == 0.0f && offset.z == 0.0f)
+        return true;
+
+    const TerrainSettings& terrain = m_settings.terrainSettings;
+    Vector3 target = {state.position.x + offset.x, state.position.y,
+                      state.position.z + offset.z};
+    target.x = utils::Clamp(target.x, -terrain.mapWidth / 2,
+                            terrain.mapWidth / 2);
+    target.z = utils::Clamp(target.z, -terrain.mapDepth / 2,
+                            terrain.mapDepth / 2);
+
+    // Same ground test as the movement step, at the destination
+    int lastTriangleIndex = state.collidingTriangleIndex;
+    std::pair<float, int> ground = m_terrain->CheckCollision(
+        target, state.radius, state.height, lastTriangleIndex);
+    if (ground.second != -1) {
+        const float climb = ground.first - (target.y - state.height / 2);
+        if (climb > STEP_UP_HEIGHT)
+            return false;
+        const float slope = Vector3DotProduct(
+            m_terrain->GetTriangleNormal(ground.second), Vector3{0, 1, 0});
+        if (climb > 0.0f && slope <= cosf(DEG2RAD * MAX_CLIMBABLE_SLOPE))
+            return false;
+    }
+
+    state.position.x = target.x;
+    state.position.z = target.z;
+    return true;
+}
+
+}  // namespace arena
@@ -0,0 +1,190 @@
+#include "pose_cache.h"
+#include <algorithm>
+#include <cmath>
+#include "logger.h"
+#include "raymath.h"
+#include "utils.h"
+
+namespace arena {
+
+static const float NORMAL_SCALE = 1.0f / 32767.0f;
+
+static int16_t quantize(const float value, const float step) {
+    float q = std::round(value / step);
+    return (int16_t)std::max(-32767.0f, std::min(32767.0f, q));
+}
+
+static void decodeBone(const QuantizedBoneMatrix& in, const float positionStep,
+                       const float translationStep, BoneMatrix& out) {
+    for (int i = 0; i < 12; i++) {
+        out.position[i] = in.position[i] *
+                          ((i & 3) == 3 ? translationStep : positionStep);
+        out.normal[i] = in.normal[i] * NORMAL_SCALE;
+    }
+}
+
+static void lerpBone(const BoneMatrix& a, const BoneMatrix& b, const float t,
+                     BoneMatrix& out) {
+    for (int i = 0; i < 12; i++) {
+        out.position[i] = a.position[i] + (b.position[i] - a.position[i]) * t;
+        out.normal[i] = a.normal[i] + (b.normal[i] - a.normal[i]) * t;
+    }
+}
+
+PoseCache::PoseCache(const Model& model, const AnimationClipSet& clips,
+                     const PoseBakeOptions& options)
+    : m_options(options), m_boneCount(model.boneCount) {
+    utils::Stopwatch timer;
+    if (m_options.samplesPerFrame <= 0.0f) {
+        LOG_WARNING("Invalid pose bake rate, using one sample per frame");
+        m_options.samplesPerFrame = 1.0f;
+    }
+
+    std::vector<BoneMatrix> palettes;
+    for (int i = 0; i < clips.GetClipCount(); i++) {
+        BakedClip baked;
+        baked.sampleCount = bakeClip(model, clips, i, palettes);
+        if (m_options.quantize) {
+            baked.firstPalette = m_quantized.size();
+            quantizeClip(palettes, baked);
+        } else {
+            baked.firstPalette = m_palettes.size();
+            m_palettes.insert(m_palettes.end(), palettes.begin(),
+                              palettes.end());
+        }
+        m_clips.push_back(baked);
+    }
+
+    LOG_INFO("Baked ", m_clips.size(), " clips from ", clips.GetPath(), " (",
+             GetMemoryBytes(), " bytes",
+             m_options.quantize ? ", quantized" : "", ") in ",
+             timer.ElapsedMs(), " ms");
+}
+
+int PoseCache::bakeClip(const Model& model, const AnimationClipSet& clips,
+                        const AnimationHandle clip,
+                        std::vector<BoneMatrix>& outPalettes) const {
+    const int frameCount = clips.GetFrameCount(clip);
+    const int sampleCount = std::max(
+        1, (int)std::ceil(frameCount * m_options.samplesPerFrame));
+    const int clipBones =
+        frameCount > 0 ? std::min(clips.GetBoneCount(clip), m_boneCount) : 0;
+
+    // Bones the clip does not animate stay in bind pose
+    std::vector<Transform> pose(model.bindPose, model.bindPose + m_boneCount);
+    std::vector<Transform> scratch0(clips.GetBoneCount(clip));
+    std::vector<Transform> scratch1(clips.GetBoneCount(clip));
+    std::vector<BoneMatrix> palette;
+    outPalettes.resize((size_t)sampleCount * m_boneCount);
+
+    for (int s = 0; s < sampleCount; s++) {
+        // Sample between keyframes, the last keyframe is held to the end
+        const float frame = s / m_options.samplesPerFrame;
+        const int f0 = std::min((int)frame, frameCount - 1);
+        const int f1 = std::min(f0 + 1, frameCount - 1);
+        const float t = std::min(frame - f0, 1.0f);
+        if (clipBones > 0) {
+            const Transform* a = clips.GetPose(clip, f0, scratch0.data());
+            const Transform* c = clips.GetPose(clip, f1, scratch1.data());
+            for (int b = 0; b < clipBones; b++) {
+                pose[b].translation =
+                    Vector3Lerp(a[b].translation, c[b].translation, t);
+                pose[b].rotation =
+                    QuaternionSlerp(a[b].rotation, c[b].rotation, t);
+                pose[b].scale = Vector3Lerp(a[b].scale, c[b].scale, t);
+            }
+        }
+
+        SkinnedModel::ComputePalette(model, pose.data(), palette);
+        std::copy(palette.begin(), palette.end(),
+                  outPalettes.begin() + (size_t)s * m_boneCount);
+    }
+    return sampleCount;
+}
+
+void PoseCache::quantizeClip(const std::vector<BoneMatrix>& palettes,
+                             BakedClip& outClip) {
+    // One step per clip for the scaled rotation and one for translations
+    float maxLinear = 0.0f;
+    float maxTranslation = 0.0f;
+    for (const BoneMatrix& bone : palettes) {
+        for (int i = 0; i < 12; i++) {
+            float value = std::fabs(bone.position[i]);
+            if ((i & 3) == 3)
+                maxTranslation = std::max(maxTranslation, value);
+            else
+                maxLinear = std::max(maxLinear, value);
+        }
+    }
+    outClip.positionScale = std::max(maxLinear, 1e-6f) / 32767.0f;
+    outClip.translationScale = std::max(maxTranslation, 1e-6f) / 32767.0f;
+
+    for (const BoneMatrix& bone : palettes) {
+        QuantizedBoneMatrix q;
+        for (int i = 0; i < 12; i++) {
+            q.position[i] = quantize(bone.position[i],
+                                     (i & 3) == 3 ? outClip.translationScale
+                                                  : outClip.positionScale);
+            q.normal[i] = quantize(bone.normal[i], NORMAL_SCALE);
+        }
+        m_quantized.push_back(q);
+    }
+}
+
+const BoneMatrix* PoseCache::GetPalette(AnimationHandle clip,
+                                        int sample) const {
+    if (m_options.quantize)
+        return nullptr;
+    const BakedClip& baked = m_clips[clip];
+    return &m_palettes[baked.firstPalette + (size_t)sample * m_boneCount];
+}
+
+int PoseCache::GetSampleIndex(AnimationHandle clip, float frame) const {
+    const int sampleCount = m_clips[clip].sampleCount;
+    int sample = (int)(std::max(frame, 0.0f) * m_options.samplesPerFrame);
+    return sample % sampleCount;
+}
+
+void PoseCache::Sample(AnimationHandle clip, float frame, bool interpolate,
+                       BoneMatrix* outPalette) const {
+    const BakedClip& baked = m_clips[clip];
+    const float position = std::max(frame, 0.0f) * m_options.samplesPerFrame;
+    const int s0 = (int)position % baked.sampleCount;
+    const int s1 = (s0 + 1) % baked.sampleCount;  // Looping clips wrap
+    const float t = position - std::floor(position);
+    const bool lerp = interpolate && t > 0.0f && s1 != s0;
+
+    const size_t first0 = baked.firstPalette + (size_t)s0 * m_boneCount;
+    const size_t first1 = baked.firstPalette + (size_t)s1 * m_boneCount;
+    if (!m_options.quantize) {
+        if (!lerp) {
+            std::copy(&m_palettes[first0], &m_palettes[first0] + m_boneCount,
+                      outPalette);
+            return;
+        }
+        for (int b = 0; b < m_boneCount; b++) {
+            lerpBone(m_palettes[first0 + b], m_palettes[first1 + b], t,
+                     outPalette[b]);
+        }
+        return;
+    }
+
+    for (int b = 0; b < m_boneCount; b++) {
+        decodeBone(m_quantized[first0 + b], baked.positionScale,
+                   baked.translationScale, outPalette[b]);
+        if (lerp) {
+            BoneMatrix next;
+            decodeBone(m_quantized[first1 + b], baked.positionScale,
+                       baked.translationScale, next);
+            lerpBone(outPalette[b], next, t, outPalette[b]);
+        }
+    }
+}
+
+size_t PoseCache::GetMemoryBytes() const {
+    return m_clips.size() * sizeof(BakedClip) +
+           m_palettes.size() * sizeof(BoneMatrix) +
+           m_quantized.size() * sizeof(QuantizedBoneMatrix);
+}
+
+}  // namespace arena
@@ -0,0 +1,109 @@
+#include "prediction.h"
+#include "logger.h"
+#include "utils.h"
+
+namespace arena {
+
+LocalAuthority::LocalAuthority(const PlayerSimulation& simulation,
+                               const PlayerState& initialState,
+                               const float latency)
+    : m_simulation(simulation),
+      m_authoritative(initialState),
+      m_latency(latency) {}
+
+void LocalAuthority::Send(const InputCommand& command, const double now) {
+    m_incoming.push_back({now + m_latency, command});
+}
+
+void LocalAuthority::Update(const double now) {
+    while (!m_incoming.empty() && m_incoming.front().deliveryTime <= now) {
+        const InputCommand& command = m_incoming.front().payload;
+        m_simulation.Simulate(m_authoritative.state, command.input,
+                              command.deltaTime);
+        m_simulation.Displace(m_authoritative.state, command.separation);
+        m_authoritative.lastProcessedSequence = command.sequence;
+        m_outgoing.push_back({now + m_latency, m_authoritative});
+        m_incoming.pop_front();
+    }
+}
+
+bool LocalAuthority::ReceiveSnapshot(const double now,
+                                     StateSnapshot& outSnapshot) {
+    // Only the newest delivered snapshot matters to the client
+    bool received = false;
+    while (!m_outgoing.empty() && m_outgoing.front().deliveryTime <= now) {
+        outSnapshot = m_outgoing.front().payload;
+        m_outgoing.pop_front();
+        received = true;
+    }
+    return received;
+}
+
+PredictionClient::PredictionClient(const NetworkSettings& settings,
+                                   const PlayerSimulation& simulation)
+    : m_settings(settings), m_simulation(simulation) {}
+
+InputCommand PredictionClient::CreateCommand(const PlayerInput& input,
+                                             const float deltaTime,
+                                             const Vector3& separation) {
+    InputCommand command;
+    command.sequence = m_nextSequence++;
+    command.input = input;
+    command.deltaTime = deltaTime;
+    command.separation = separation;
+    return command;
+}
+
+void PredictionClient::StorePrediction(const InputCommand& command,
+                                       const PlayerState& predicted) {
+    m_pending.push_back({command, predicted});
+    if ((int)m_pending.size() > m_settings.maxPendingInputs) {
+        LOG_WARNING("Too many unacknowledged inputs, dropping sequence ",
+                    m_pending.front().command.sequence);
+        m_pending.pop_front();
+    }
+    m_stats.pendingInputs = (int)m_pending.size();
+}
+
+bool PredictionClient::Reconcile(const StateSnapshot& snapshot,
+                                 PlayerState& inOutState) {
+    utils::Stopwatch timer;
+    m_stats.snapshotsReceived++;
+
+    // Inputs older than the acknowledged one will never be compared
+    const unsigned int acked = snapshot.lastProcessedSequence;
+    while (!m_pending.empty() && m_pending.front().command.sequence < acked) {
+        m_pending.pop_front();
+    }
+
+    bool corrected = false;
+    if (!m_pending.empty() && m_pending.front().command.sequence == acked) {
+        float error = Vector3Distance(m_pending.front().predicted.position,
+                                      snapshot.state.position);
+        m_pending.pop_front();
+        m_stats.lastError = error;
+
+        if (error > m_settings.reconcileTolerance) {
+            m_stats.mispredictions++;
+            LOG_DEBUG("Misprediction at sequence ", acked, ", error ", error);
+
+            // Rewind to the authoritative state and replay pending inputs
+            PlayerState state = snapshot.state;
+            for (PendingInput& pending : m_pending) {
+                m_simulation.Simulate(state, pending.command.input,
+                                      pending.command.deltaTime);
+                m_simulation.Displace(state, pending.command.separation);
+                pending.predicted = state;
+                m_stats.replayedInputs++;
+            }
+            inOutState = state;
+            corrected = true;
+        }
+    }
+
+    m_stats.pendingInputs = (int)m_pending.size();
+    m_stats.reconcileTimeMs += timer.ElapsedMs();
+    return corrected;
+}
+
+}  // namespace arena
@@ -0,0 +1,70 @@
+#include "render_graph.h"
+#include "logger.h"
+#include "rlgl.h"
+#include "utils.h"
+
+namespace arena {
+
+bool RenderGraph::AddPass(const std::string& name, const unsigned int inputs,
+                          PassFunction execute) {
+    if ((inputs & RENDER_INPUT_LIGHTING) && !(inputs & RENDER_INPUT_CAMERA)) {
+        LOG_ERROR("Lit render pass needs the camera: ", name);
+        return false;
+    }
+    for (const RenderPassStats& stats : m_stats) {
+        if (stats.name == name) {
+            LOG_ERROR("Render pass registered twice: ", name);
+            return false;
+        }
+    }
+
+    m_passes.push_back(RenderPass{inputs, std::move(execute)});
+    RenderPassStats stats;
+    stats.name = name;
+    m_stats.push_back(stats);
+    return true;
+}
+
+void RenderGraph::runPasses(const unsigned int inputs) {
+    for (size_t i = 0; i < m_passes.size(); i++) {
+        if (m_passes[i].inputs != inputs)
+            continue;
+
+        utils::Stopwatch timer;
+        m_stats[i].drawCalls = m_passes[i].execute();
+        // Flush batched geometry so it is timed with the pass that drew it
+        rlDrawRenderBatchActive();
+        m_stats[i].timeMs = timer.ElapsedMs();
+    }
+}
+
+void RenderGraph::Execute(const Camera3D& camera, const Shader& lighting) {
+    BeginMode3D(camera);
+
+    BeginShaderMode(lighting);
+    runPasses(RENDER_INPUT_CAMERA | RENDER_INPUT_LIGHTING);
+    EndShaderMode();
+
+    runPasses(RENDER_INPUT_CAMERA);
+    EndMode3D();
+
+    runPasses(0);
+}
+
+int RenderGraph::GetDrawCalls() const {
+    int drawCalls = 0;
+    for (const RenderPassStats& stats : m_stats) {
+        drawCalls += stats.drawCalls;
+    }
+    return drawCalls;
+}
+
+float RenderGraph::GetTimeMs() const {
+    float timeMs = 0.0f;
+    for (const RenderPassStats& stats : m_stats) {
+        timeMs += stats.timeMs;
+    }
+    return timeMs;
+}
+
+}  // namespace arena
@@ -0,0 +1,120 @@
+#include "render_queue.h"
+#include <cstring>
+#include "raymath.h"
+#include "utils.h"
+
+namespace arena {
+
+static unsigned int getTextureId(const Material& material) {
+    return material.maps ? material.maps[MATERIAL_MAP_DIFFUSE].texture.id : 0;
+}
+
+uint64_t RenderQueue::MakeKey(const unsigned int pass,
+                              const unsigned int shader,
+                              const unsigned int texture,
+                              const float distance) {
+    uint32_t depth = 0;
+    if (distance > 0.0f)
+        std::memcpy(&depth, &distance, sizeof(depth));
+    return ((uint64_t)(pass < 0xFu ? pass : 0xFu) << 60) |
+           ((uint64_t)(shader & 0xFFFu) << 48) |
+           ((uint64_t)(texture & 0xFFFFu) << 32) | depth;
+}
+
+void RenderQueue::Begin(const Vector3& viewPosition) {
+    m_viewPosition = viewPosition;
+    m_items.clear();
+    m_order.clear();
+    m_stats = RenderQueueStats();
+}
+
+void RenderQueue::Add(const unsigned int pass, const Mesh& mesh,
+                      const Material& material, const Matrix& transform,
+                      const Vector3& position) {
+    // Squared distance orders the same and skips the square root
+    const float distance = Vector3DistanceSqr(position, m_viewPosition);
+    m_order.push_back(SortEntry{
+        MakeKey(pass, material.shader.id, getTextureId(material), distance),
+        (uint32_t)m_items.size()});
+    m_items.push_back(DrawItem{mesh, material, transform});
+}
+
+void RenderQueue::AddModel(const unsigned int pass, const Model& model,
+                           const Matrix& transform, const Vector3& position) {
+    for (int i = 0; i < model.meshCount; i++) {
+        Add(pass, model.meshes[i], model.materials[model.meshMaterial[i]],
+            transform, position);
+    }
+}
+
+void RenderQueue::Sort() {
+    utils::Stopwatch timer;
+    m_stats.items = (int)m_items.size();
+    m_stats.stateChangesBefore = countStateChanges(false);
+    m_stats.sortPasses = radixSort();
+    m_stats.stateChangesAfter = countStateChanges(true);
+    m_stats.sortTimeMs = timer.ElapsedMs();
+}
+
+int RenderQueue::radixSort() {
+    // Least significant byte first. All eight histograms are built in one
+    // read, and a byte every key shares is skipped without moving keys.
+    const int count = (int)m_order.size();
+    uint32_t histograms[8][256] = {{0}};
+    for (const SortEntry& entry : m_order) {
+        for (int byte = 0; byte < 8; byte++) {
+            histograms[byte][(entry.key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    m_scratch.resize(count);
+    int passes = 0;
+    for (int byte = 0; byte < 8; byte++) {
+        uint32_t* histogram = histograms[byte];
+        const int shift = byte * 8;
+        if (count == 0 ||
+            histogram[(m_order[0].key >> shift) & 0xFF] == (uint32_t)count)
+            continue;
+
+        // Turn counts into the first output slot of each bucket
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            const uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (const SortEntry& entry : m_order) {
+            m_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        m_order.swap(m_scratch);
+        passes++;
+    }
+    return passes;
+}
+
+int RenderQueue::countStateChanges(const bool sorted) const {
+    int changes = 0;
+    unsigned int shader = 0;
+    unsigned int texture = 0;
+    for (size_t i = 0; i < m_items.size(); i++) {
+        const Material& material =
+            m_items[sorted ? m_order[i].index : i].material;
+        if (i == 0 || material.shader.id != shader)
+            changes++;
+        if (i == 0 || getTextureId(material) != texture)
+            changes++;
+        shader = material.shader.id;
+        texture = getTextureId(material);
+    }
+    return changes;
+}
+
+int RenderQueue::Draw() const {
+    for (const SortEntry& entry : m_order) {
+        const DrawItem& item = m_items[entry.index];
+        DrawMesh(item.mesh, item.material, item.transform);
+    }
+    return (int)m_order.size();
+}
+
+}  // namespace arena
@@ -1,10 +1,12 @@
 #include "shader_handler.h"
+#include <algorithm>
 #include "logger.h"
+#include "raymath.h"
 
 namespace arena {
 
-ShaderHandler::ShaderHandler(const Settings& settings, Camera* camera)
-    : m_camera(camera), m_settings(settings) {}
+ShaderHandler::ShaderHandler(const Settings& settings)
+    : m_settings(settings) {}
 
 ShaderHandler::~ShaderHandler() {
     UnloadShader(m_shader);
@@ -46,11 +48,55 @@ bool ShaderHandler::Load(const char* vertexShaderPath,
     int ambientLoc = GetShaderLocation(m_shader, "ambient");
 
     float ambient[4] = {0.3f, 0.3f, 0.3f, 1.0f};
-    SetShaderValue(m_shader, ambientLoc, ambient, SHADER_UNIFORM_VEC4);
+    setUniform(ambientLoc, ambient, 4, SHADER_UNIFORM_VEC4);
+
+    // Constant per-shader values; the cache keeps them from being resent
+    setUniformMatrix(m_shader.locs[SHADER_LOC_MATRIX_MODEL], MatrixIdentity());
+    setUniformMatrix(m_shader.locs[SHADER_LOC_MATRIX_NORMAL],
+                     MatrixIdentity());
+    Vector4 diffuse = ColorNormalize(WHITE);
+    setUniform(m_shader.locs[SHADER_LOC_COLOR_DIFFUSE], &diffuse.x, 4,
+               SHADER_UNIFORM_VEC4);
 
     return true;
 }
 
+bool ShaderHandler::updateCache(const int location, const float* value,
+                                const int count) {
+    if (location < 0)
+        return false;
+
+    std::vector<float>& cached = m_uniforms[location];
+    if (cached.size() == (size_t)count &&
+        std::equal(cached.begin(), cached.end(), value)) {
+        m_stats.skipped++;
+        return false;
+    }
+    cached.assign(value, value + count);
+    m_stats.uploaded++;
+    return true;
+}
+
+void ShaderHandler::setUniform(const int location, const float* value,
+                               const int count, const int uniformType) {
+    if (updateCache(location, value, count))
+        SetShaderValue(m_shader, location, value, uniformType);
+}
+
+void ShaderHandler::setUniformInt(const int location, const int value) {
+    // Cached as a float, exact for the flags and enums sent this way
+    const float cached = (float)value;
+    if (updateCache(location, &cached, 1))
+        SetShaderValue(m_shader, location, &value, SHADER_UNIFORM_INT);
+}
+
+void ShaderHandler::setUniformMatrix(const int location,
+                                     const Matrix& value) {
+    float16 values = MatrixToFloatV(value);
+    if (updateCache(location, values.v, 16))
+        SetShaderValueMatrix(m_shader, location, value);
+}
+
 void ShaderHandler::Begin() {
     BeginShaderMode(m_shader);
 }
@@ -59,40 +105,26 @@ void ShaderHandler::End() {
     EndShaderMode();
 }
 
-void ShaderHandler::Update() {
-    Vector3 pos = m_camera->GetPosition();
-    float cameraPos[3] = {pos.x, pos.y, pos.z};
-    SetShaderValue(m_shader, m_shader.locs[SHADER_LOC_VECTOR_VIEW], cameraPos,
-                   SHADER_UNIFORM_VEC3);
-
-    // Update shader values
-    Matrix viewProjection = MatrixMultiply(
-        MatrixLookAt(m_camera->GetCamera().position,
-                     m_camera->GetCamera().target, m_camera->GetCamera().up),
-        MatrixPerspective(m_camera->GetCamera().fovy * DEG2RAD,
-                          (float)m_settings.windowSettings.screenWidth /
-                              (float)m_settings.windowSettings.screenHeight,
-                          0.1f, 1000.0f));
-
-    SetShaderValueMatrix(m_shader, m_shader.locs[SHADER_LOC_MATRIX_MVP],
-                         viewProjection);
-    SetShaderValueMatrix(m_shader, m_shader.locs[SHADER_LOC_MATRIX_MODEL],
-                         MatrixIdentity());
-    SetShaderValueMatrix(m_shader, m_shader.locs[SHADER_LOC_MATRIX_NORMAL],
-                         MatrixTranspose(MatrixInvert(MatrixIdentity())));
-    SetShaderValue(m_shader, m_shader.locs[SHADER_LOC_VECTOR_VIEW],
-                   &m_camera->GetCamera().position.x, SHADER_UNIFORM_VEC3);
-
-    Color diffuseColor = WHITE;
-    SetShaderValue(m_shader, m_shader.locs[SHADER_LOC_COLOR_DIFFUSE],
-                   &diffuseColor, SHADER_UNIFORM_VEC4);
-
-    LOG_DEBUG(
-        "Shader MVP Matrix: %s",
-        TextFormat("%.2f %.2f %.2f %.2f", viewProjection.m0, viewProjection.m1,
-                   viewProjection.m2, viewProjection.m3));
+void ShaderHandler::ResetFrameStats() {
+    m_stats = ShaderUniformStats();
+}
+
+void ShaderHandler::SetCameraPosition(const Vector3& position) {
+    // rlgl writes mvp itself before every draw, so the view position is
+    // the only per-frame uniform; it is skipped while the camera is still
+    setUniform(m_shader.locs[SHADER_LOC_VECTOR_VIEW], &position.x, 3,
+               SHADER_UNIFORM_VEC3);
 }
 
-void ShaderHandler::SetCameraPosition(const Vector3& position) {}
+void ShaderHandler::SetLight(const Light& light) {
+    // Same uniforms as rlights' UpdateLightValues, only the changed ones
+    // are sent
+    setUniformInt(light.enabledLoc, light.enabled ? 1 : 0);
+    setUniformInt(light.typeLoc, light.type);
+    setUniform(light.positionLoc, &light.position.x, 3, SHADER_UNIFORM_VEC3);
+    setUniform(light.targetLoc, &light.target.x, 3, SHADER_UNIFORM_VEC3);
+    const Vector4 color = ColorNormalize(light.color);
+    setUniform(light.colorLoc, &color.x, 4, SHADER_UNIFORM_VEC4);
+}
 
 }  // namespace arena
\ No newline at end of file
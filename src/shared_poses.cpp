@@ -0,0 +1,59 @@
+#include "shared_poses.h"
+#include "asset_cache.h"
+#include "logger.h"
+
+namespace arena {
+
+SharedPoses::SharedPoses(const PlayerSettings& settings,
+                         AnimationSystem& animations)
+    : m_settings(settings), m_animations(animations) {}
+
+SharedPoses::~SharedPoses() {
+    for (Pose& pose : m_poses) {
+        if (pose.animation)
+            m_animations.Remove(pose.animation.get());
+        pose.animation.reset();
+        if (pose.model.meshCount > 0)
+            UnloadModel(pose.model);
+    }
+}
+
+bool SharedPoses::Initialize() {
+    // Every copy loads the same file, read it once
+    std::shared_ptr<const AssetBlob> asset =
+        AssetCache::Acquire(m_settings.model);
+
+    AnimationManager clips(m_settings);
+    if (!clips.LoadAnimations(m_settings.model)) {
+        LOG_ERROR("Failed to load animations for shared poses");
+        return false;
+    }
+
+    m_poses.resize(clips.GetAnimationCount());
+    for (int clip = 0; clip < (int)m_poses.size(); clip++) {
+        Pose& pose = m_poses[clip];
+        pose.model = LoadModel(m_settings.model);
+        if (pose.model.meshCount == 0) {
+            LOG_ERROR("Failed to load shared pose model: ", m_settings.model);
+            return false;
+        }
+        pose.animation = std::make_unique<AnimationManager>(m_settings);
+        if (!pose.animation->LoadAnimations(m_settings.model)) {
+            LOG_ERROR("Failed to load animations for shared poses");
+            return false;
+        }
+        pose.animation->BindModel(pose.model);
+        pose.animation->SetAnimation(clip);
+        m_animations.Add(pose.animation.get());
+    }
+    LOG_INFO("Created ", m_poses.size(), " shared character poses");
+    return true;
+}
+
+const Model* SharedPoses::GetModel(const AnimationHandle clip) const {
+    if (clip < 0 || clip >= (int)m_poses.size() || !m_poses[clip].animation)
+        return nullptr;
+    return &m_poses[clip].model;
+}
+
+}  // namespace arena
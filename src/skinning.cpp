@@ -0,0 +1,295 @@
+#include "skinning.h"
+#include <algorithm>
+#include "logger.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ARENA_SKINNING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace arena {
+
+bool SkinnedModel::Initialize(const Model& model) {
+    m_model = model;
+    m_meshes.clear();
+    m_meshIndices.clear();
+
+    for (int m = 0; m < model.meshCount; m++) {
+        const Mesh& mesh = model.meshes[m];
+        if (mesh.boneIds == nullptr || mesh.boneWeights == nullptr ||
+            mesh.animVertices == nullptr) {
+            continue;
+        }
+
+        SkinnedMeshStreams streams;
+        const int count = mesh.vertexCount;
+        streams.vertexCount = count;
+        streams.hasNormals = mesh.normals != nullptr &&
+                             mesh.animNormals != nullptr;
+        streams.px.resize(count);
+        streams.py.resize(count);
+        streams.pz.resize(count);
+        if (streams.hasNormals) {
+            streams.nx.resize(count);
+            streams.ny.resize(count);
+            streams.nz.resize(count);
+        }
+        streams.boneIds.assign(mesh.boneIds, mesh.boneIds + count * 4);
+        streams.boneWeights.assign(mesh.boneWeights,
+                                   mesh.boneWeights + count * 4);
+
+        for (int v = 0; v < count; v++) {
+            streams.px[v] = mesh.vertices[v * 3];
+            streams.py[v] = mesh.vertices[v * 3 + 1];
+            streams.pz[v] = mesh.vertices[v * 3 + 2];
+            if (streams.hasNormals) {
+                streams.nx[v] = mesh.normals[v * 3];
+                streams.ny[v] = mesh.normals[v * 3 + 1];
+                streams.nz[v] = mesh.normals[v * 3 + 2];
+            }
+        }
+
+        // Guard the kernel against bone ids outside the skeleton
+        for (unsigned char& id : streams.boneIds) {
+            if (id >= model.boneCount)
+                id = 0;
+        }
+
+        m_meshes.push_back(streams);
+        m_meshIndices.push_back(m);
+    }
+
+    m_palette.assign(std::max(model.boneCount, 1), BoneMatrix());
+    m_activePalette = m_palette.data();
+    LOG_DEBUG("Skinned model: ", m_meshes.size(), " skinned meshes, ",
+              model.boneCount, " bones");
+    return !m_meshes.empty();
+}
+
+void SkinnedModel::ComputePalette(const Model& model, const Transform* pose,
+                                  std::vector<BoneMatrix>& outPalette) {
+    outPalette.resize(model.boneCount);
+    ComputePalette(model, pose, outPalette.data());
+}
+
+void SkinnedModel::ComputePalette(const Model& model, const Transform* pose,
+                                  BoneMatrix* outPalette) {
+    for (int b = 0; b < model.boneCount; b++) {
+        const Transform& bind = model.bindPose[b];
+        const Transform& target = pose[b];
+
+        // v' = R * (S * (v - bindTranslation)) + targetTranslation
+        Quaternion rotation = QuaternionMultiply(
+            target.rotation, QuaternionInvert(bind.rotation));
+        Matrix r = QuaternionToMatrix(rotation);
+        const float rows[3][3] = {{r.m0, r.m4, r.m8},
+                                  {r.m1, r.m5, r.m9},
+                                  {r.m2, r.m6, r.m10}};
+        const float scale[3] = {target.scale.x, target.scale.y,
+                                target.scale.z};
+        const float bindT[3] = {bind.translation.x, bind.translation.y,
+                                bind.translation.z};
+        const float targetT[3] = {target.translation.x,
+                                  target.translation.y,
+                                  target.translation.z};
+
+        BoneMatrix& bone = outPalette[b];
+        for (int i = 0; i < 3; i++) {
+            float translation = targetT[i];
+            for (int j = 0; j < 3; j++) {
+                float m = rows[i][j] * scale[j];
+                bone.position[i * 4 + j] = m;
+                bone.normal[i * 4 + j] = rows[i][j];
+                translation -= m * bindT[j];
+            }
+            bone.position[i * 4 + 3] = translation;
+            bone.normal[i * 4 + 3] = 0.0f;
+        }
+    }
+}
+
+void SkinnedModel::BlendPalettes(const BoneMatrix* from, const BoneMatrix* to,
+                                 const float weight, const int boneCount,
+                                 BoneMatrix* outPalette) {
+    // Palettes are plain float arrays, blend them as one flat stream
+    const int count = boneCount * (int)(sizeof(BoneMatrix) / sizeof(float));
+    const float* a = reinterpret_cast<const float*>(from);
+    const float* b = reinterpret_cast<const float*>(to);
+    float* out = reinterpret_cast<float*>(outPalette);
+
+    int i = 0;
+#ifdef ARENA_SKINNING_SSE
+    const __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 va = _mm_loadu_ps(a + i);
+        const __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(out + i,
+                      _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), w)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = a[i] + (b[i] - a[i]) * weight;
+    }
+}
+
+void SkinnedModel::SetPose(const Transform* pose) {
+    ComputePalette(m_model, pose, m_palette);
+    m_activePalette = m_palette.data();
+}
+
+void SkinnedModel::SetPalette(const std::vector<BoneMatrix>& palette) {
+    m_palette = palette;
+    m_activePalette = m_palette.data();
+}
+
+// Scalar reference path, also used for the tail of each range
+static inline void skinVertex(const SkinnedMeshStreams& streams,
+                              const BoneMatrix* palette, const int v,
+                              float* outPosition, float* outNormal) {
+    float p[3] = {0, 0, 0};
+    float n[3] = {0, 0, 0};
+    for (int j = 0; j < 4; j++) {
+        float weight = streams.boneWeights[v * 4 + j];
+        if (weight == 0.0f)
+            continue;
+        const BoneMatrix& bone = palette[streams.boneIds[v * 4 + j]];
+        for (int i = 0; i < 3; i++) {
+            const float* row = &bone.position[i * 4];
+            p[i] += weight * (row[0] * streams.px[v] + row[1] * streams.py[v] +
+                              row[2] * streams.pz[v] + row[3]);
+            if (outNormal) {
+                const float* nrow = &bone.normal[i * 4];
+                n[i] += weight *
+                        (nrow[0] * streams.nx[v] + nrow[1] * streams.ny[v] +
+                         nrow[2] * streams.nz[v]);
+            }
+        }
+    }
+    outPosition[0] = p[0];
+    outPosition[1] = p[1];
+    outPosition[2] = p[2];
+    if (outNormal) {
+        outNormal[0] = n[0];
+        outNormal[1] = n[1];
+        outNormal[2] = n[2];
+    }
+}
+
+void SkinnedModel::Skin(const int meshIndex, const int firstVertex,
+                        const int lastVertex) {
+    const SkinnedMeshStreams& streams = m_meshes[meshIndex];
+    const Mesh& mesh = m_model.meshes[m_meshIndices[meshIndex]];
+    const BoneMatrix* palette = m_activePalette;
+    float* outPositions = mesh.animVertices;
+    float* outNormals = streams.hasNormals ? mesh.animNormals : nullptr;
+    const int end = std::min(lastVertex, streams.vertexCount);
+
+    int v = firstVertex;
+#ifdef ARENA_SKINNING_SSE
+    // Four vertices per iteration: blend each vertex's bone rows, transpose
+    // the blended rows into columns, then transform the SoA streams
+    for (; v + 4 <= end; v += 4) {
+        __m128 rows[3][4];
+        __m128 normalRows[3][4];
+        for (int k = 0; k < 4; k++) {
+            __m128 r0 = _mm_setzero_ps(), r1 = _mm_setzero_ps(),
+                   r2 = _mm_setzero_ps();
+            __m128 n0 = _mm_setzero_ps(), n1 = _mm_setzero_ps(),
+                   n2 = _mm_setzero_ps();
+            const int base = (v + k) * 4;
+            for (int j = 0; j < 4; j++) {
+                const float weight = streams.boneWeights[base + j];
+                if (weight == 0.0f)
+                    continue;
+                const BoneMatrix& bone = palette[streams.boneIds[base + j]];
+                const __m128 w = _mm_set1_ps(weight);
+                r0 = _mm_add_ps(r0, _mm_mul_ps(w, _mm_loadu_ps(bone.position)));
+                r1 = _mm_add_ps(r1,
+                                _mm_mul_ps(w, _mm_loadu_ps(bone.position + 4)));
+                r2 = _mm_add_ps(r2,
+                                _mm_mul_ps(w, _mm_loadu_ps(bone.position + 8)));
+                if (outNormals) {
+                    n0 = _mm_add_ps(n0,
+                                    _mm_mul_ps(w, _mm_loadu_ps(bone.normal)));
+                    n1 = _mm_add_ps(
+                        n1, _mm_mul_ps(w, _mm_loadu_ps(bone.normal + 4)));
+                    n2 = _mm_add_ps(
+                        n2, _mm_mul_ps(w, _mm_loadu_ps(bone.normal + 8)));
+                }
+            }
+            rows[0][k] = r0;
+            rows[1][k] = r1;
+            rows[2][k] = r2;
+            normalRows[0][k] = n0;
+            normalRows[1][k] = n1;
+            normalRows[2][k] = n2;
+        }
+
+        const __m128 x = _mm_loadu_ps(&streams.px[v]);
+        const __m128 y = _mm_loadu_ps(&streams.py[v]);
+        const __m128 z = _mm_loadu_ps(&streams.pz[v]);
+        float result[3][4];
+        for (int i = 0; i < 3; i++) {
+            _MM_TRANSPOSE4_PS(rows[i][0], rows[i][1], rows[i][2], rows[i][3]);
+            __m128 value =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(rows[i][0], x),
+                                      _mm_mul_ps(rows[i][1], y)),
+                           _mm_add_ps(_mm_mul_ps(rows[i][2], z), rows[i][3]));
+            _mm_storeu_ps(result[i], value);
+        }
+        for (int k = 0; k < 4; k++) {
+            outPositions[(v + k) * 3] = result[0][k];
+            outPositions[(v + k) * 3 + 1] = result[1][k];
+            outPositions[(v + k) * 3 + 2] = result[2][k];
+        }
+
+        if (outNormals) {
+            const __m128 nx = _mm_loadu_ps(&streams.nx[v]);
+            const __m128 ny = _mm_loadu_ps(&streams.ny[v]);
+            const __m128 nz = _mm_loadu_ps(&streams.nz[v]);
+            for (int i = 0; i < 3; i++) {
+                _MM_TRANSPOSE4_PS(normalRows[i][0], normalRows[i][1],
+                                  normalRows[i][2], normalRows[i][3]);
+                __m128 value =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalRows[i][0], nx),
+                                          _mm_mul_ps(normalRows[i][1], ny)),
+                               _mm_mul_ps(normalRows[i][2], nz));
+                _mm_storeu_ps(result[i], value);
+            }
+            for (int k = 0; k < 4; k++) {
+                outNormals[(v + k) * 3] = result[0][k];
+                outNormals[(v + k) * 3 + 1] = result[1][k];
+                outNormals[(v + k) * 3 + 2] = result[2][k];
+            }
+        }
+    }
+#endif
+
+    for (; v < end; v++) {
+        skinVertex(streams, palette, v, &outPositions[v * 3],
+                   outNormals ? &outNormals[v * 3] : nullptr);
+    }
+}
+
+void SkinnedModel::SkinAll() {
+    for (int m = 0; m < (int)m_meshes.size(); m++) {
+        Skin(m, 0, m_meshes[m].vertexCount);
+    }
+}
+
+void SkinnedModel::Upload() {
+    // Only the animated streams change, the rest of the mesh stays on GPU
+    for (int m = 0; m < (int)m_meshes.size(); m++) {
+        const Mesh& mesh = m_model.meshes[m_meshIndices[m]];
+        const int size = mesh.vertexCount * 3 * sizeof(float);
+        rlUpdateVertexBuffer(mesh.vboId[0], mesh.animVertices, size, 0);
+        if (m_meshes[m].hasNormals) {
+            rlUpdateVertexBuffer(mesh.vboId[2], mesh.animNormals, size, 0);
+        }
+    }
+}
+
+}  // namespace arena
@@ -1,6 +1,8 @@
 #include "terrain.h"
 #include "debug.h"
+#include "debug_draw.h"
 #include "logger.h"
+#include "rlgl.h"
 #include "utils.h"
 
 namespace arena {
@@ -9,14 +11,29 @@ Terrain::Terrain(const TerrainSettings& settings)
     : m_modelPath(settings.model) {}
 
 Terrain::~Terrain() {
+    // UnloadModel() unloads any shader but the default one
+    if (m_customShader) {
+        for (int i = 0; i < m_model.materialCount; i++) {
+            m_model.materials[i].shader.id = rlGetShaderIdDefault();
+            m_model.materials[i].shader.locs = rlGetShaderLocsDefault();
+        }
+    }
     UnloadModel(m_model);
 }
 
+void Terrain::SetShader(const Shader& shader) {
+    for (int i = 0; i < m_model.materialCount; i++) {
+        m_model.materials[i].shader = shader;
+    }
+    m_customShader = true;
+}
+
 bool Terrain::Initialize() {
     if (!LoadTerrainModel(m_modelPath))
         return false;
 
     m_colliders = utils::LoadCollidersFromMesh(m_model.meshes[0]);
+    computeMeshBounds();
 
     return true;
 }
@@ -51,21 +68,55 @@ bool Terrain::LoadTerrainModel(const char* modelPath) {
     return true;
 }
 
-void Terrain::Draw() {
-    // Draw terrain model and debug colliders
-    DrawModelEx(m_model, Vector3Zero(), Vector3{1, 0, 0}, 0.0f, Vector3One(),
-                WHITE);
+int Terrain::Submit(RenderQueue& queue, const unsigned int pass,
+                    const CullingSystem& culling, const int cullingId) const {
+    // The terrain is drawn untransformed and untinted, so each mesh can be
+    // drawn on its own with the model transform
+    int submitted = 0;
+    for (int i = 0; i < m_model.meshCount; i++) {
+        if (!culling.IsMeshVisible(cullingId, i))
+            continue;
+        const BoundingBox& box = m_meshBounds[i];
+        queue.Add(pass, m_model.meshes[i],
+                  m_model.materials[m_model.meshMaterial[i]], m_model.transform,
+                  Vector3Scale(Vector3Add(box.min, box.max), 0.5f));
+        submitted++;
+    }
+    return submitted;
+}
+
+void Terrain::computeMeshBounds() {
+    m_meshBounds.clear();
+    m_meshBounds.reserve(m_model.meshCount);
+    for (int i = 0; i < m_model.meshCount; i++) {
+        BoundingBox box = GetMeshBoundingBox(m_model.meshes[i]);
+        // Transform the corners into world space and rebound them
+        Vector3 corners[8];
+        for (int c = 0; c < 8; c++) {
+            corners[c] = Vector3Transform(
+                Vector3{(c & 1) ? box.max.x : box.min.x,
+                        (c & 2) ? box.max.y : box.min.y,
+                        (c & 4) ? box.max.z : box.min.z},
+                m_model.transform);
+        }
+        box.min = box.max = corners[0];
+        for (int c = 1; c < 8; c++) {
+            box.min = Vector3Min(box.min, corners[c]);
+            box.max = Vector3Max(box.max, corners[c]);
+        }
+        m_meshBounds.push_back(box);
+    }
 }
 
 void Terrain::DrawCollidingTriangle(const int triangleIndex,
-                                    const Vector3& colliderPosition) {
+                                    const Vector3& colliderPosition) const {
     // Draw colliding triangle
     if (triangleIndex != -1 && triangleIndex * 3 + 2 < m_colliders.size()) {
         Vector3 v1 = m_colliders[triangleIndex * 3];
         Vector3 v2 = m_colliders[triangleIndex * 3 + 1];
         Vector3 v3 = m_colliders[triangleIndex * 3 + 2];
-        DrawTriangle3D(v1, v2, v3, RED);
-        DrawSphere(colliderPosition, 0.1f, GRAY);
+        DebugDraw::Triangle(DEBUG_DRAW_TERRAIN, v1, v2, v3, RED);
+        DebugDraw::Sphere(DEBUG_DRAW_TERRAIN, colliderPosition, 0.1f, GRAY);
     }
 }
 
@@ -101,7 +152,7 @@ Vector3 Terrain::GetTriangleNormal(const int triangleIndex) const {
 
 std::pair<float, int> Terrain::CheckCollision(
     const Vector3& position, const float radius, const float height,
-    int& outLastCollidingTriangleIndex) {
+    int& outLastCollidingTriangleIndex) const {
     if (m_colliders.size() % 3 != 0) {
         LOG_DEBUG("Collider vector size is not a multiple of 3. Size: ",
                   m_colliders.size());
@@ -186,5 +186,109 @@ bool CheckCollisionSphereTriangle(const Vector3& center, const float radius,
     return false;
 }
 
+bool GetRayCollisionCapsule(const Ray& ray, const Vector3& a, const Vector3& b,
+                            const float radius, RayCollision& outCollision) {
+    outCollision = RayCollision{0};
+    Vector3 ba = Vector3Subtract(b, a);
+    float baba = Vector3DotProduct(ba, ba);
+
+    // Degenerate capsule is a plain sphere
+    if (baba < 1e-8f) {
+        outCollision = GetRayCollisionSphere(ray, a, radius);
+        return outCollision.hit;
+    }
+
+    Vector3 oa = Vector3Subtract(ray.position, a);
+    float bard = Vector3DotProduct(ba, ray.direction);
+    float baoa = Vector3DotProduct(ba, oa);
+    float rdoa = Vector3DotProduct(ray.direction, oa);
+    float oaoa = Vector3DotProduct(oa, oa);
+
+    float qa = baba - bard * bard;
+    float qb = baba * rdoa - baoa * bard;
+    float qc = baba * oaoa - baoa * baoa - radius * radius * baba;
+    float h = qb * qb - qa * qc;
+    if (h < 0.0f)
+        return false;
+
+    // Cylinder body
+    float t = -1.0f;
+    if (qa > 1e-8f) {
+        t = (-qb - sqrtf(h)) / qa;
+        float y = baoa + t * bard;
+        if (y <= 0.0f || y >= baba)
+            t = -1.0f;
+    }
+
+    // End caps
+    if (t < 0.0f) {
+        float best = -1.0f;
+        const Vector3 caps[2] = {a, b};
+        for (const Vector3& cap : caps) {
+            RayCollision capHit = GetRayCollisionSphere(ray, cap, radius);
+            if (capHit.hit && (best < 0.0f || capHit.distance < best))
+                best = capHit.distance;
+        }
+        t = best;
+    }
+
+    if (t < 0.0f)
+        return false;
+
+    Vector3 point = Vector3Add(ray.position, Vector3Scale(ray.direction, t));
+    float s = Clamp(Vector3DotProduct(Vector3Subtract(point, a), ba) / baba,
+                    0.0f, 1.0f);
+    Vector3 closest = Vector3Add(a, Vector3Scale(ba, s));
+
+    outCollision.hit = true;
+    outCollision.distance = t;
+    outCollision.point = point;
+    outCollision.normal = Vector3Normalize(Vector3Subtract(point, closest));
+    return true;
+}
+
+void ClosestPointsSegmentSegment(const Vector3& p1, const Vector3& q1,
+                                 const Vector3& p2, const Vector3& q2,
+                                 Vector3& outC1, Vector3& outC2) {
+    const float epsilon = 1e-8f;
+    Vector3 d1 = Vector3Subtract(q1, p1);
+    Vector3 d2 = Vector3Subtract(q2, p2);
+    Vector3 r = Vector3Subtract(p1, p2);
+    float a = Vector3DotProduct(d1, d1);
+    float e = Vector3DotProduct(d2, d2);
+    float f = Vector3DotProduct(d2, r);
+    float s = 0.0f;
+    float t = 0.0f;
+
+    if (a <= epsilon && e <= epsilon) {
+        // Both segments degenerate into points
+    } else if (a <= epsilon) {
+        t = Clamp(f / e, 0.0f, 1.0f);
+    } else {
+        float c = Vector3DotProduct(d1, r);
+        if (e <= epsilon) {
+            s = Clamp(-c / a, 0.0f, 1.0f);
+        } else {
+            float b = Vector3DotProduct(d1, d2);
+            float denom = a * e - b * b;
+
+            // Parallel segments pick an arbitrary s
+            s = denom > epsilon ? Clamp((b * f - c * e) / denom, 0.0f, 1.0f)
+                                : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = Clamp(-c / a, 0.0f, 1.0f);
+            } else if (t > 1.0f) {
+                t = 1.0f;
+                s = Clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    outC1 = Vector3Add(p1, Vector3Scale(d1, s));
+    outC2 = Vector3Add(p2, Vector3Scale(d2, t));
+}
+
 }  // namespace utils
 }  // namespace arena
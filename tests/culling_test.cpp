@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <vector>
+#include "culling.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "test.h"
+
+using namespace arena;
+
+// Cube from -10 to 10 on every axis
+static Frustum cubeFrustum() {
+    return Frustum::FromMatrix(MatrixScale(0.1f, 0.1f, 0.1f));
+}
+
+static BoundingBox box(const Vector3& min, const Vector3& max) {
+    return BoundingBox{min, max};
+}
+
+static BoundingBox unitBox() {
+    return box(Vector3{-1, -1, -1}, Vector3{1, 1, 1});
+}
+
+static float planeDistance(const Vector4& plane, const Vector3& point) {
+    return plane.x * point.x + plane.y * point.y + plane.z * point.z +
+           plane.w;
+}
+
+static void checkPlane(const Vector4& plane, const Vector4& expected) {
+    CHECK_NEAR(plane.x, expected.x, 1e-4);
+    CHECK_NEAR(plane.y, expected.y, 1e-4);
+    CHECK_NEAR(plane.z, expected.z, 1e-4);
+    CHECK_NEAR(plane.w, expected.w, 1e-4);
+}
+
+static void testPlanesFromScale() {
+    const Frustum frustum = cubeFrustum();
+    checkPlane(frustum.planes[0], Vector4{1, 0, 0, 10});   // Left
+    checkPlane(frustum.planes[1], Vector4{-1, 0, 0, 10});  // Right
+    checkPlane(frustum.planes[2], Vector4{0, 1, 0, 10});   // Bottom
+    checkPlane(frustum.planes[3], Vector4{0, -1, 0, 10});  // Top
+    checkPlane(frustum.planes[4], Vector4{0, 0, 1, 10});   // Near
+    checkPlane(frustum.planes[5], Vector4{0, 0, -1, 10});  // Far
+}
+
+static void testPlanesFromCamera() {
+    // 90 degree view down -Z, so the side planes are at 45 degrees
+    Camera3D camera = {0};
+    camera.position = Vector3{0, 0, 0};
+    camera.target = Vector3{0, 0, -1};
+    camera.up = Vector3{0, 1, 0};
+    camera.fovy = 90.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    const Frustum frustum = Frustum::FromCamera(camera, 1.0f);
+
+    const float s = sqrtf(0.5f);
+    checkPlane(frustum.planes[0], Vector4{s, 0, -s, 0});
+    checkPlane(frustum.planes[1], Vector4{-s, 0, -s, 0});
+    checkPlane(frustum.planes[2], Vector4{0, s, -s, 0});
+    checkPlane(frustum.planes[3], Vector4{0, -s, -s, 0});
+    checkPlane(frustum.planes[4],
+               Vector4{0, 0, -1, -(float)RL_CULL_DISTANCE_NEAR});
+    CHECK_NEAR(frustum.planes[5].z, 1.0, 1e-4);
+    // Float extraction loses precision with the 1e5 far/near ratio
+    CHECK_NEAR(frustum.planes[5].w, RL_CULL_DISTANCE_FAR, 2.0);
+
+    const Vector3 inside = {1, 2, -5};
+    for (const Vector4& plane : frustum.planes)
+        CHECK(planeDistance(plane, inside) > 0.0f);
+    CHECK(planeDistance(frustum.planes[4], Vector3{0, 0, 5}) < 0.0f);
+    CHECK(planeDistance(frustum.planes[1], Vector3{6, 0, -5}) < 0.0f);
+    CHECK(planeDistance(frustum.planes[3], Vector3{0, 6, -5}) < 0.0f);
+}
+
+static void testClassification() {
+    CullingSystem culling;
+    const int inside = culling.AddObject({unitBox()});
+    const int outside = culling.AddObject({unitBox()});
+    const int straddling = culling.AddObject({unitBox()});
+    const int below = culling.AddObject({unitBox()});
+    culling.SetPosition(outside, Vector3{20, 0, 0});
+    culling.SetPosition(straddling, Vector3{10, 0, 0});
+    culling.SetPosition(below, Vector3{0, -11.5f, 0});
+    culling.Cull(cubeFrustum());
+
+    CHECK(culling.IsVisible(inside));
+    CHECK(!culling.IsVisible(outside));
+    CHECK(culling.IsVisible(straddling));
+    CHECK(!culling.IsVisible(below));
+    const CullingStats& stats = culling.GetStats();
+    CHECK(stats.objects == 4);
+    CHECK(stats.visibleObjects == 2);
+    CHECK(stats.culledObjects == 2);
+    // Single-mesh objects never have their meshes tested
+    CHECK(stats.boxesTested == 4);
+}
+
+static void testEveryLane() {
+    // Padding lanes hold empty boxes at the origin, which is inside the
+    // frustum; they must never show up as visible objects
+    for (int count = 1; count <= 9; count++) {
+        for (int shown = 0; shown < count; shown++) {
+            CullingSystem culling;
+            for (int i = 0; i < count; i++) {
+                const int id = culling.AddObject({unitBox()});
+                culling.SetPosition(id, i == shown ? Vector3{0, 0, 0}
+                                                   : Vector3{0, 0, 50});
+            }
+            culling.Cull(cubeFrustum());
+            const std::vector<int>& visible = culling.GetVisibleObjects();
+            CHECK(visible.size() == 1);
+            CHECK(!visible.empty() && visible[0] == shown);
+            CHECK(culling.GetStats().objects == count);
+            CHECK(culling.GetStats().boxesTested == count);
+        }
+    }
+
+    CullingSystem culling;
+    for (int i = 0; i < 5; i++) {
+        const int id = culling.AddObject({unitBox()});
+        culling.SetPosition(id, Vector3{50, 0, 0});
+    }
+    culling.Cull(cubeFrustum());
+    CHECK(culling.GetVisibleObjects().empty());
+    CHECK(culling.GetStats().culledObjects == 5);
+}
+
+static void testMeshCulling() {
+    CullingSystem culling;
+    // Union straddles the right plane, one mesh inside and one beyond it
+    const int partial = culling.AddObject(
+        {unitBox(), box(Vector3{30, -1, -1}, Vector3{31, 1, 1})});
+    // Union spans the whole frustum, both meshes are outside it
+    const int hollow =
+        culling.AddObject({box(Vector3{-30, -1, -1}, Vector3{-20, 1, 1}),
+                           box(Vector3{20, -1, -1}, Vector3{30, 1, 1})});
+    // Fully inside, meshes are not tested
+    const int whole = culling.AddObject(
+        {unitBox(), box(Vector3{2, 2, 2}, Vector3{3, 3, 3})});
+    culling.Cull(cubeFrustum());
+
+    CHECK(culling.IsVisible(partial));
+    CHECK(culling.IsMeshVisible(partial, 0));
+    CHECK(!culling.IsMeshVisible(partial, 1));
+    CHECK(!culling.IsVisible(hollow));
+    CHECK(!culling.IsMeshVisible(hollow, 0));
+    CHECK(!culling.IsMeshVisible(hollow, 1));
+    CHECK(culling.IsVisible(whole));
+    CHECK(culling.IsMeshVisible(whole, 0));
+    CHECK(culling.IsMeshVisible(whole, 1));
+    CHECK(!culling.IsMeshVisible(whole, 2));
+
+    const CullingStats& stats = culling.GetStats();
+    CHECK(stats.meshes == 6);
+    CHECK(stats.visibleMeshes == 3);
+    CHECK(stats.culledMeshes == 3);
+    CHECK(stats.boxesTested == 3 + 2 + 2);
+
+    // Moved left, the other mesh is now the visible one
+    culling.SetPosition(partial, Vector3{-25, 0, 0});
+    culling.Cull(cubeFrustum());
+    CHECK(!culling.IsMeshVisible(partial, 0));
+    CHECK(culling.IsMeshVisible(partial, 1));
+}
+
+static void testIdReuse() {
+    CullingSystem culling;
+    const int pair = culling.AddObject({unitBox(), unitBox()});
+    const int single = culling.AddObject({unitBox()});
+
+    culling.RemoveObject(pair);
+    culling.RemoveObject(pair);
+    // Too many meshes for the freed slots
+    const int triple = culling.AddObject({unitBox(), unitBox(), unitBox()});
+    CHECK(triple != pair);
+    CHECK(triple != single);
+    // Fits, and takes the new bounds rather than the old ones
+    const int reused =
+        culling.AddObject({box(Vector3{40, 0, 0}, Vector3{41, 1, 1})});
+    CHECK(reused == pair);
+    // Removing twice freed the id once
+    const int fresh = culling.AddObject({unitBox()});
+    CHECK(fresh != pair);
+
+    culling.RemoveObject(single);
+    culling.Cull(cubeFrustum());
+    CHECK(!culling.IsVisible(reused));
+    CHECK(!culling.IsMeshVisible(reused, 1));
+    CHECK(!culling.IsVisible(single));
+    CHECK(culling.IsVisible(triple));
+    CHECK(culling.IsVisible(fresh));
+    const std::vector<int>& visible = culling.GetVisibleObjects();
+    CHECK(std::find(visible.begin(), visible.end(), single) ==
+          visible.end());
+    CHECK(culling.GetStats().objects == 3);
+    CHECK(culling.GetStats().meshes == 5);
+
+    // Out of range ids are ignored
+    culling.RemoveObject(-1);
+    culling.RemoveObject(100);
+    culling.SetPosition(100, Vector3{0, 0, 0});
+    CHECK(!culling.IsVisible(100));
+}
+
+int main() {
+    testPlanesFromScale();
+    testPlanesFromCamera();
+    testClassification();
+    testEveryLane();
+    testMeshCulling();
+    testIdReuse();
+#ifdef ARENA_CULLING_NO_SSE
+    return test::Finish("culling (scalar)");
+#else
+    return test::Finish("culling");
+#endif
+}
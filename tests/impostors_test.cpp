@@ -0,0 +1,133 @@
+#include "impostor_selector.h"
+#include "raymath.h"
+#include "test.h"
+
+using namespace arena;
+
+static const int VIEWS = 8;
+
+// Viewer on the horizontal circle around the origin, at the given angle
+// from +Z towards +X
+static Vector3 viewerAt(const float angle) {
+    return Vector3{sinf(angle) * 10.0f, 0.0f, cosf(angle) * 10.0f};
+}
+
+static void testViews() {
+    const Vector3 origin = {0, 0, 0};
+    const float step = 2.0f * PI / VIEWS;
+    // Viewer straight ahead and at each rendered angle
+    for (int view = 0; view < VIEWS; view++) {
+        CHECK(ImpostorSelector::GetView(origin, 0.0f, viewerAt(view * step),
+                                        VIEWS) == view);
+    }
+    // Rounds to the nearest view, not down
+    CHECK(ImpostorSelector::GetView(origin, 0.0f, viewerAt(0.4f * step),
+                                    VIEWS) == 0);
+    CHECK(ImpostorSelector::GetView(origin, 0.0f, viewerAt(0.6f * step),
+                                    VIEWS) == 1);
+    CHECK(ImpostorSelector::GetView(origin, 0.0f, viewerAt(-0.4f * step),
+                                    VIEWS) == 0);
+    CHECK(ImpostorSelector::GetView(origin, 0.0f, viewerAt(-0.6f * step),
+                                    VIEWS) == VIEWS - 1);
+
+    // Turning the character turns the view the other way
+    CHECK(ImpostorSelector::GetView(origin, 2 * step, viewerAt(0.0f),
+                                    VIEWS) == VIEWS - 2);
+    CHECK(ImpostorSelector::GetView(origin, -2 * step, viewerAt(0.0f),
+                                    VIEWS) == 2);
+
+    // Viewer behind, either side of the atan2 discontinuity
+    CHECK(ImpostorSelector::GetView(origin, 0.0f,
+                                    Vector3{-0.001f, 0.0f, -10.0f},
+                                    VIEWS) == VIEWS / 2);
+    CHECK(ImpostorSelector::GetView(origin, 0.0f,
+                                    Vector3{0.001f, 0.0f, -10.0f},
+                                    VIEWS) == VIEWS / 2);
+
+    // Yaw beyond a full turn either way wraps around
+    for (int turns = -3; turns <= 3; turns++) {
+        const float yaw = turns * 2.0f * PI - step;
+        CHECK(ImpostorSelector::GetView(origin, yaw, viewerAt(0.0f),
+                                        VIEWS) == 1);
+        CHECK(ImpostorSelector::GetView(origin, yaw, viewerAt(PI),
+                                        VIEWS) == VIEWS / 2 + 1);
+    }
+
+    // Only the offset to the viewer matters, not where the pair is
+    const Vector3 position = {-30, 5, 70};
+    CHECK(ImpostorSelector::GetView(position, 0.0f,
+                                    Vector3Add(position, viewerAt(3 * step)),
+                                    VIEWS) == 3);
+
+    CHECK(ImpostorSelector::GetView(origin, 1.0f, viewerAt(2.0f), 1) == 0);
+    CHECK(ImpostorSelector::GetView(origin, 1.0f, viewerAt(2.0f), 0) == 0);
+}
+
+static void testHysteresis() {
+    ImpostorSettings settings;
+    ImpostorSelector selector(settings);
+    const int id = selector.AddCharacter();
+    const Vector3 viewer = {0, 0, 0};
+    const float far = settings.distance + settings.hysteresis;
+    const float near = settings.distance - settings.hysteresis;
+    auto at = [](const float distance) { return Vector3{0, 0, distance}; };
+
+    // A mesh stays a mesh until past the far boundary
+    CHECK(selector.Select(id, at(settings.distance + 1), 0.0f, viewer) == -1);
+    CHECK(selector.Select(id, at(far - 0.1f), 0.0f, viewer) == -1);
+    CHECK(!selector.IsImpostor(id));
+    CHECK(selector.GetStats().switches == 0);
+    CHECK(selector.Select(id, at(far + 0.1f), 0.0f, viewer) >= 0);
+    CHECK(selector.IsImpostor(id));
+    CHECK(selector.GetStats().switches == 1);
+
+    // and an impostor stays one until inside the near boundary
+    CHECK(selector.Select(id, at(settings.distance - 1), 0.0f, viewer) >= 0);
+    CHECK(selector.Select(id, at(near + 0.1f), 0.0f, viewer) >= 0);
+    CHECK(selector.IsImpostor(id));
+    CHECK(selector.Select(id, at(near - 0.1f), 0.0f, viewer) == -1);
+    CHECK(!selector.IsImpostor(id));
+
+    const ImpostorStats& stats = selector.GetStats();
+    CHECK(stats.characters == 6);
+    CHECK(stats.impostors == 3);
+    CHECK(stats.switches == 2);
+    selector.ResetFrameStats();
+    CHECK(selector.GetStats().characters == 0);
+    CHECK(selector.GetStats().switches == 0);
+
+    // Far away, the view follows the direction to the viewer
+    CHECK(selector.Select(id, Vector3{0, 0, -100}, 0.0f, viewer) == 0);
+    CHECK(selector.Select(id, Vector3{100, 0, 0}, 0.0f, viewer) ==
+          ImpostorSelector::GetView(Vector3{100, 0, 0}, 0.0f, viewer,
+                                    settings.viewAngles));
+}
+
+static void testIds() {
+    ImpostorSettings settings;
+    ImpostorSelector selector(settings);
+    const int first = selector.AddCharacter();
+    const int second = selector.AddCharacter();
+    CHECK(first != second);
+    const Vector3 viewer = {0, 0, 0};
+    selector.Select(first, Vector3{0, 0, 1000}, 0.0f, viewer);
+    CHECK(selector.IsImpostor(first));
+    CHECK(!selector.IsImpostor(second));
+
+    // A reused id starts over as a mesh
+    selector.RemoveCharacter(first);
+    selector.RemoveCharacter(first);
+    selector.RemoveCharacter(-1);
+    const int reused = selector.AddCharacter();
+    CHECK(reused == first);
+    CHECK(!selector.IsImpostor(reused));
+    const int fresh = selector.AddCharacter();
+    CHECK(fresh != first && fresh != second);
+}
+
+int main() {
+    testViews();
+    testHysteresis();
+    testIds();
+    return test::Finish("impostors");
+}
@@ -0,0 +1,129 @@
+#include "instancing.h"
+#include "raymath.h"
+#include "test.h"
+
+using namespace arena;
+
+// Stand-ins for loaded GPU resources, only their ids matter for batching
+struct FakeMesh {
+    unsigned int vbo[2];
+    Mesh mesh;
+
+    FakeMesh(const unsigned int vao, const unsigned int vertexBuffer)
+        : vbo{vertexBuffer, 0}, mesh() {
+        mesh.vaoId = vao;
+        mesh.vboId = vbo;
+    }
+};
+
+struct FakeMaterial {
+    MaterialMap maps[MATERIAL_MAP_BRDF + 1];
+    Material material;
+
+    FakeMaterial(const unsigned int shader, const unsigned int texture)
+        : maps(), material() {
+        maps[MATERIAL_MAP_DIFFUSE].texture.id = texture;
+        material.shader.id = shader;
+        material.maps = maps;
+    }
+};
+
+static void testSharedBatches() {
+    FakeMesh body(1, 10);
+    FakeMesh head(2, 20);
+    FakeMaterial skin(3, 100);
+    FakeMaterial cloth(3, 101);
+
+    InstancedRenderer renderer;
+    renderer.Begin();
+    for (int i = 0; i < 5; i++) {
+        renderer.Add(body.mesh, skin.material,
+                     MatrixTranslate((float)i, 0.0f, 0.0f));
+    }
+    renderer.Add(head.mesh, skin.material, MatrixIdentity());
+    renderer.Add(body.mesh, cloth.material, MatrixIdentity());
+    renderer.Add(head.mesh, skin.material, MatrixIdentity());
+
+    CHECK(renderer.GetBatchCount() == 3);
+    CHECK(renderer.GetStats().batches == 3);
+    CHECK(renderer.GetStats().instances == 8);
+    CHECK(renderer.GetStats().drawCalls == 0);
+    // Batches keep the order they were first seen in, and their
+    // transforms the order they were added in
+    CHECK(renderer.GetBatch(0).mesh.vaoId == 1);
+    CHECK(renderer.GetBatch(0).transforms.size() == 5);
+    CHECK(renderer.GetBatch(0).transforms[3].m12 == 3.0f);
+    CHECK(renderer.GetBatch(1).mesh.vaoId == 2);
+    CHECK(renderer.GetBatch(1).transforms.size() == 2);
+    CHECK(renderer.GetBatch(2).transforms.size() == 1);
+    CHECK(renderer.GetBatch(2).material.maps[MATERIAL_MAP_DIFFUSE]
+              .texture.id == 101);
+}
+
+static void testBatchKeys() {
+    FakeMesh mesh(1, 10);
+    FakeMesh otherBuffer(1, 11);  // Same vertex array, other vertex buffer
+    FakeMaterial material(3, 100);
+    FakeMaterial otherShader(4, 100);
+
+    InstancedRenderer renderer;
+    renderer.Begin();
+    renderer.Add(mesh.mesh, material.material, MatrixIdentity());
+    renderer.Add(otherBuffer.mesh, material.material, MatrixIdentity());
+    renderer.Add(mesh.mesh, otherShader.material, MatrixIdentity());
+    CHECK(renderer.GetBatchCount() == 3);
+
+    // Meshes and materials without buffers or maps still batch together
+    Mesh bare = {0};
+    Material plain = {0};
+    renderer.Add(bare, plain, MatrixIdentity());
+    renderer.Add(bare, plain, MatrixIdentity());
+    CHECK(renderer.GetBatchCount() == 4);
+    CHECK(renderer.GetBatch(3).transforms.size() == 2);
+    CHECK(renderer.GetStats().instances == 5);
+}
+
+static void testModels() {
+    FakeMesh meshes[3] = {FakeMesh(1, 10), FakeMesh(2, 20), FakeMesh(3, 30)};
+    FakeMaterial materials[2] = {FakeMaterial(5, 100), FakeMaterial(5, 101)};
+    Mesh modelMeshes[3] = {meshes[0].mesh, meshes[1].mesh, meshes[2].mesh};
+    Material modelMaterials[2] = {materials[0].material,
+                                  materials[1].material};
+    int meshMaterial[3] = {0, 1, 0};
+    Model model = {0};
+    model.meshCount = 3;
+    model.materialCount = 2;
+    model.meshes = modelMeshes;
+    model.materials = modelMaterials;
+    model.meshMaterial = meshMaterial;
+
+    InstancedRenderer renderer;
+    const int characters = 10;
+    renderer.Begin();
+    for (int i = 0; i < characters; i++) {
+        renderer.AddModel(model, MatrixTranslate(0.0f, 0.0f, (float)i));
+    }
+    CHECK(renderer.GetBatchCount() == 3);
+    CHECK(renderer.GetStats().instances == 3 * characters);
+    for (int i = 0; i < renderer.GetBatchCount(); i++) {
+        CHECK(renderer.GetBatch(i).transforms.size() == (size_t)characters);
+    }
+    CHECK(renderer.GetBatch(1).material.maps[MATERIAL_MAP_DIFFUSE]
+              .texture.id == 101);
+
+    // A new frame starts empty and refills the same batches
+    renderer.Begin();
+    CHECK(renderer.GetBatchCount() == 0);
+    CHECK(renderer.GetStats().instances == 0);
+    renderer.AddModel(model, MatrixIdentity());
+    CHECK(renderer.GetBatchCount() == 3);
+    CHECK(renderer.GetBatch(0).transforms.size() == 1);
+    CHECK(renderer.GetStats().instances == 3);
+}
+
+int main() {
+    testSharedBatches();
+    testBatchKeys();
+    testModels();
+    return test::Finish("instancing");
+}
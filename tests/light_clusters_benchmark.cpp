@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <vector>
+#include "light_clusters.h"
+#include "raymath.h"
+#include "test.h"
+#include "utils.h"
+
+using namespace arena;
+
+static const int RUNS = 200;
+
+int main() {
+    LightingSettings settings;
+    Camera3D camera = {0};
+    camera.position = Vector3{0, 2, -80};
+    camera.target = Vector3{0, 2, 0};
+    camera.up = Vector3{0, 1, 0};
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    // From the default scene's light count up to a full light buffer
+    const int counts[] = {settings.pointLights, 64, 128,
+                          settings.maxPointLights};
+    for (const int count : counts) {
+        test::Random random(5u);
+        std::vector<PointLight> lights(count);
+        for (PointLight& light : lights) {
+            light.position = Vector3{random.Range(-80, 80),
+                                     settings.pointLightHeight,
+                                     random.Range(-80, 80)};
+            light.radius = settings.pointLightRadius;
+        }
+
+        LightClusters clusters(settings);
+        utils::Stopwatch timer;
+        for (int run = 0; run < RUNS; run++) {
+            clusters.Build(lights, camera, 16.0f / 9.0f);
+        }
+        const double buildMs = timer.ElapsedMs() / RUNS;
+        const LightClusterStats& stats = clusters.GetStats();
+        std::printf("%3d lights (%3d visible): %6d assignments, "
+                    "%7d clusters tested, %.3f ms\n",
+                    count, stats.visibleLights, stats.assignments,
+                    stats.testedClusters, buildMs);
+    }
+    return 0;
+}
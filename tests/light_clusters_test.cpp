@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <vector>
+#include "light_clusters.h"
+#include "raymath.h"
+#include "test.h"
+
+using namespace arena;
+
+static const int LIGHT_COUNT = 200;
+static const int SAMPLE_COUNT = 20000;
+
+static Camera3D testCamera() {
+    // Off axis, so the view transform matters
+    Camera3D camera = {0};
+    camera.position = Vector3{3, 4, -10};
+    camera.target = Vector3{5, 2, 20};
+    camera.up = Vector3{0, 1, 0};
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    return camera;
+}
+
+static std::vector<PointLight> randomLights(test::Random& random) {
+    std::vector<PointLight> lights(LIGHT_COUNT);
+    for (PointLight& light : lights) {
+        light.position = Vector3{random.Range(-60, 60), random.Range(-5, 10),
+                                 random.Range(-20, 160)};
+        light.radius = random.Range(0.5f, 15.0f);
+    }
+    return lights;
+}
+
+static void testCoverage() {
+    LightingSettings settings;
+    LightClusters clusters(settings);
+    const Camera3D camera = testCamera();
+    const float aspect = 16.0f / 9.0f;
+    test::Random random(99u);
+    const std::vector<PointLight> lights = randomLights(random);
+    clusters.Build(lights, camera, aspect);
+
+    const LightClusterStats& stats = clusters.GetStats();
+    CHECK(stats.lights == LIGHT_COUNT);
+    CHECK(stats.visibleLights > 0);
+    CHECK(stats.droppedAssignments == 0);
+    CHECK((int)clusters.GetLightIndices().size() == stats.assignments);
+    int total = 0;
+    for (int cluster = 0; cluster < clusters.GetClusterCount(); cluster++) {
+        CHECK(clusters.GetClusterOffset(cluster) == total);
+        total += clusters.GetClusterLightCount(cluster);
+    }
+    CHECK(total == stats.assignments);
+
+    // Sample points across the view volume and find their cluster the way
+    // the shader does, from the screen tile and the view depth
+    const Matrix view =
+        MatrixLookAt(camera.position, camera.target, camera.up);
+    const Matrix inverseView = MatrixInvert(view);
+    const float tanY = tanf(camera.fovy * 0.5f * DEG2RAD);
+    const float tanX = tanY * aspect;
+    const std::vector<int>& indices = clusters.GetLightIndices();
+    int missing = 0;
+    int lit = 0;
+    for (int sample = 0; sample < SAMPLE_COUNT; sample++) {
+        const float ndcX = random.Range(-0.999f, 0.999f);
+        const float ndcY = random.Range(-0.999f, 0.999f);
+        const float depth =
+            settings.clusterNear *
+            powf(settings.clusterFar / settings.clusterNear,
+                 random.Range(0.0f, 0.999f));
+        const Vector3 viewPoint = {ndcX * tanX * depth, ndcY * tanY * depth,
+                                   -depth};
+        const Vector3 point = Vector3Transform(viewPoint, inverseView);
+
+        const int x = (int)((ndcX + 1.0f) * 0.5f * settings.clusterTilesX);
+        const int y = (int)((ndcY + 1.0f) * 0.5f * settings.clusterTilesY);
+        const int cluster =
+            clusters.GetClusterIndex(x, y, clusters.GetSlice(depth));
+        const int* first = indices.data() + clusters.GetClusterOffset(cluster);
+        const int* last = first + clusters.GetClusterLightCount(cluster);
+
+        for (int light = 0; light < LIGHT_COUNT; light++) {
+            if (Vector3Distance(point, lights[light].position) >=
+                lights[light].radius)
+                continue;
+            lit++;
+            if (std::find(first, last, light) == last) {
+                missing++;
+                if (missing <= 5) {
+                    std::printf("light %d reaches (%g %g %g) but is not in "
+                                "cluster %d\n",
+                                light, point.x, point.y, point.z, cluster);
+                }
+            }
+        }
+    }
+    std::printf("light clusters: %d light and sample pairs, %d assignments\n",
+                lit, stats.assignments);
+    CHECK(lit > 0);
+    CHECK(missing == 0);
+}
+
+static void testOutOfRange() {
+    LightingSettings settings;
+    LightClusters clusters(settings);
+    const Camera3D camera = testCamera();
+    const Vector3 forward = Vector3Normalize(
+        Vector3Subtract(camera.target, camera.position));
+
+    std::vector<PointLight> lights(3);
+    // Behind the camera
+    lights[0].position = Vector3Subtract(camera.position,
+                                         Vector3Scale(forward, 5.0f));
+    lights[0].radius = 2.0f;
+    // Beyond the far slice
+    lights[1].position = Vector3Add(
+        camera.position, Vector3Scale(forward, settings.clusterFar + 10));
+    lights[1].radius = 5.0f;
+    // Straight ahead
+    lights[2].position =
+        Vector3Add(camera.position, Vector3Scale(forward, 20.0f));
+    lights[2].radius = 1.0f;
+    clusters.Build(lights, camera, 1.0f);
+
+    const LightClusterStats& stats = clusters.GetStats();
+    CHECK(stats.visibleLights == 1);
+    const std::vector<int>& indices = clusters.GetLightIndices();
+    CHECK(!indices.empty());
+    CHECK(std::count(indices.begin(), indices.end(), 2) ==
+          (long)indices.size());
+
+    // Rebuilding replaces the previous lists
+    clusters.Build(std::vector<PointLight>(), camera, 1.0f);
+    CHECK(clusters.GetLightIndices().empty());
+    CHECK(clusters.GetStats().assignments == 0);
+}
+
+int main() {
+    testCoverage();
+    testOutOfRange();
+#ifdef ARENA_CLUSTERS_NO_SSE
+    return test::Finish("light clusters (scalar)");
+#else
+    return test::Finish("light clusters");
+#endif
+}
@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <vector>
+#include "culling.h"
+#include "occlusion.h"
+#include "raymath.h"
+#include "test.h"
+#include "utils.h"
+
+using namespace arena;
+
+static const int GRID_CELLS = 48;  // Terrain cells per side
+static const int BOX_COUNT = 10000;
+static const int RENDER_RUNS = 200;
+static const int TEST_RUNS = 20;
+
+// Rolling heightfield, two triangles per cell, with every triangle large
+// enough to be kept as an occluder
+static std::vector<Vector3> buildTerrain() {
+    const float cellSize = 4.0f;
+    const float origin = -GRID_CELLS * cellSize / 2;
+    auto vertex = [&](const int x, const int z) {
+        const float worldX = origin + x * cellSize;
+        const float worldZ = origin + z * cellSize;
+        const float height =
+            3.0f * sinf(worldX * 0.1f) * cosf(worldZ * 0.13f);
+        return Vector3{worldX, height, worldZ};
+    };
+    std::vector<Vector3> triangles;
+    for (int z = 0; z < GRID_CELLS; z++) {
+        for (int x = 0; x < GRID_CELLS; x++) {
+            triangles.insert(triangles.end(),
+                             {vertex(x, z), vertex(x, z + 1),
+                              vertex(x + 1, z + 1), vertex(x, z),
+                              vertex(x + 1, z + 1), vertex(x + 1, z)});
+        }
+    }
+    return triangles;
+}
+
+int main() {
+    Camera3D camera = {0};
+    camera.position = Vector3{0, 4, -80};
+    camera.target = Vector3{0, 2, 0};
+    camera.up = Vector3{0, 1, 0};
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    const Matrix viewProjection =
+        GetCameraViewProjection(camera, 16.0f / 9.0f);
+
+    OcclusionSettings settings;
+    OcclusionCuller culler(settings);
+    culler.SetOccluders(buildTerrain());
+
+    utils::Stopwatch timer;
+    for (int run = 0; run < RENDER_RUNS; run++) {
+        culler.Render(viewProjection);
+    }
+    const double renderMs = timer.ElapsedMs() / RENDER_RUNS;
+
+    test::Random random(7u);
+    std::vector<BoundingBox> boxes;
+    for (int i = 0; i < BOX_COUNT; i++) {
+        const Vector3 centre = {random.Range(-90, 90), random.Range(-4, 6),
+                                random.Range(-60, 90)};
+        const Vector3 half = {random.Range(0.2f, 1.0f),
+                              random.Range(0.5f, 1.5f),
+                              random.Range(0.2f, 1.0f)};
+        boxes.push_back(BoundingBox{Vector3Subtract(centre, half),
+                                    Vector3Add(centre, half)});
+    }
+    int occluded = 0;
+    timer.Reset();
+    for (int run = 0; run < TEST_RUNS; run++) {
+        for (const BoundingBox& box : boxes) {
+            occluded += culler.IsVisible(box) ? 0 : 1;
+        }
+    }
+    const double testMs = timer.ElapsedMs() / TEST_RUNS;
+
+    std::printf("rasterize %d triangles (%d after clipping): %.3f ms\n",
+                culler.GetStats().occluderTriangles,
+                culler.GetStats().rasterizedTriangles, renderMs);
+    std::printf("test %d boxes (%d occluded): %.3f ms, %.1f ns per box\n",
+                BOX_COUNT, occluded / TEST_RUNS, testMs,
+                testMs * 1e6 / BOX_COUNT);
+    return 0;
+}
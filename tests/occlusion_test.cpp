@@ -0,0 +1,202 @@
+#include <vector>
+#include "culling.h"
+#include "occlusion.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "test.h"
+
+using namespace arena;
+
+static const int BOX_COUNT = 10000;
+static const int SAMPLES_PER_EDGE = 5;  // Per face, for the reference
+
+static void addQuad(std::vector<Vector3>& triangles, const Vector3& a,
+                    const Vector3& b, const Vector3& c, const Vector3& d) {
+    triangles.insert(triangles.end(), {a, b, c, a, c, d});
+}
+
+// Walls at several depths and angles over a ground plane
+static std::vector<Vector3> buildOccluders() {
+    std::vector<Vector3> triangles;
+    addQuad(triangles, Vector3{-15, 0, 20}, Vector3{5, 0, 20},
+            Vector3{5, 10, 20}, Vector3{-15, 10, 20});
+    addQuad(triangles, Vector3{0, 0, 35}, Vector3{30, 0, 35},
+            Vector3{30, 6, 35}, Vector3{0, 6, 35});
+    addQuad(triangles, Vector3{-30, 0, 30}, Vector3{-18, 0, 45},
+            Vector3{-18, 8, 45}, Vector3{-30, 8, 30});
+    addQuad(triangles, Vector3{8, 0, 12}, Vector3{11, 0, 14},
+            Vector3{11, 3, 14}, Vector3{8, 3, 12});
+    addQuad(triangles, Vector3{-100, 0, -100}, Vector3{100, 0, -100},
+            Vector3{100, 0, 200}, Vector3{-100, 0, 200});
+    // Seen edge-on, it covers almost nothing
+    addQuad(triangles, Vector3{-5, 0, 50}, Vector3{-5, 0, 60},
+            Vector3{-5, 9, 60}, Vector3{-5, 9, 50});
+    return triangles;
+}
+
+// Distance along the ray to the triangle, or a negative value on a miss
+static float rayTriangle(const Vector3& origin, const Vector3& direction,
+                         const Vector3& v0, const Vector3& v1,
+                         const Vector3& v2) {
+    const Vector3 edge1 = Vector3Subtract(v1, v0);
+    const Vector3 edge2 = Vector3Subtract(v2, v0);
+    const Vector3 p = Vector3CrossProduct(direction, edge2);
+    const float determinant = Vector3DotProduct(edge1, p);
+    if (fabsf(determinant) < 1e-8f)
+        return -1.0f;
+    const float inverse = 1.0f / determinant;
+    const Vector3 t = Vector3Subtract(origin, v0);
+    const float u = Vector3DotProduct(t, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return -1.0f;
+    const Vector3 q = Vector3CrossProduct(t, edge1);
+    const float v = Vector3DotProduct(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return -1.0f;
+    return Vector3DotProduct(edge2, q) * inverse;
+}
+
+static bool onScreen(const Matrix& viewProjection, const Vector3& point) {
+    const Vector4 clip = {
+        viewProjection.m0 * point.x + viewProjection.m4 * point.y +
+            viewProjection.m8 * point.z + viewProjection.m12,
+        viewProjection.m1 * point.x + viewProjection.m5 * point.y +
+            viewProjection.m9 * point.z + viewProjection.m13,
+        0.0f,
+        viewProjection.m3 * point.x + viewProjection.m7 * point.y +
+            viewProjection.m11 * point.z + viewProjection.m15};
+    return clip.w >= RL_CULL_DISTANCE_NEAR && fabsf(clip.x) <= clip.w &&
+           fabsf(clip.y) <= clip.w;
+}
+
+static bool pointVisible(const Vector3& eye, const Vector3& point,
+                         const std::vector<Vector3>& occluders) {
+    const Vector3 offset = Vector3Subtract(point, eye);
+    const float distance = Vector3Length(offset);
+    const Vector3 direction = Vector3Scale(offset, 1.0f / distance);
+    for (size_t i = 0; i < occluders.size(); i += 3) {
+        const float hit = rayTriangle(eye, direction, occluders[i],
+                                      occluders[i + 1], occluders[i + 2]);
+        if (hit > 1e-3f && hit < distance - 1e-3f)
+            return false;
+    }
+    return true;
+}
+
+enum Reference { OFF_SCREEN, HIDDEN, VISIBLE };
+
+// A box is visible when any point sampled over its faces is on screen
+// and reaches the eye unobstructed. Sampling can miss thin slivers, so
+// the reference only ever errs towards hidden.
+static Reference castRays(const Vector3& eye, const Matrix& viewProjection,
+                          const BoundingBox& box,
+                          const std::vector<Vector3>& occluders) {
+    Reference result = OFF_SCREEN;
+    const float min[3] = {box.min.x, box.min.y, box.min.z};
+    const float max[3] = {box.max.x, box.max.y, box.max.z};
+    for (int axis = 0; axis < 3; axis++) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        for (int side = 0; side < 2; side++) {
+            for (int i = 0; i < SAMPLES_PER_EDGE; i++) {
+                for (int j = 0; j < SAMPLES_PER_EDGE; j++) {
+                    float point[3];
+                    point[axis] = side ? max[axis] : min[axis];
+                    point[u] = min[u] + (max[u] - min[u]) * i /
+                                            (SAMPLES_PER_EDGE - 1);
+                    point[v] = min[v] + (max[v] - min[v]) * j /
+                                            (SAMPLES_PER_EDGE - 1);
+                    const Vector3 sample = {point[0], point[1], point[2]};
+                    if (!onScreen(viewProjection, sample))
+                        continue;
+                    if (pointVisible(eye, sample, occluders))
+                        return VISIBLE;
+                    result = HIDDEN;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static void testAgainstRayCasts() {
+    Camera3D camera = {0};
+    camera.position = Vector3{0, 2, 0};
+    camera.target = Vector3{0.1f, 1.8f, 1};
+    camera.up = Vector3{0, 1, 0};
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    const Matrix viewProjection =
+        GetCameraViewProjection(camera, 16.0f / 9.0f);
+
+    const std::vector<Vector3> occluders = buildOccluders();
+    OcclusionSettings settings;
+    OcclusionCuller culler(settings);
+    culler.SetOccluders(occluders);
+    culler.Render(viewProjection);
+    CHECK(culler.GetStats().rasterizedTriangles > 0);
+
+    test::Random random(12345u);
+    int falseOcclusions = 0;
+    int hidden = 0;
+    int occluded = 0;
+    for (int i = 0; i < BOX_COUNT; i++) {
+        const Vector3 centre = {random.Range(-40, 40), random.Range(-2, 12),
+                                random.Range(3, 80)};
+        const Vector3 half = {random.Range(0.1f, 1.5f),
+                              random.Range(0.1f, 1.5f),
+                              random.Range(0.1f, 1.5f)};
+        const BoundingBox box = {Vector3Subtract(centre, half),
+                                 Vector3Add(centre, half)};
+        const bool visible = culler.IsVisible(box);
+        const Reference reference =
+            castRays(camera.position, viewProjection, box, occluders);
+        if (!visible) {
+            occluded++;
+            if (reference == VISIBLE) {
+                falseOcclusions++;
+                if (falseOcclusions <= 5) {
+                    std::printf("falsely occluded box (%g %g %g)-(%g %g %g)\n",
+                                box.min.x, box.min.y, box.min.z, box.max.x,
+                                box.max.y, box.max.z);
+                }
+            }
+        }
+        if (reference == HIDDEN)
+            hidden++;
+    }
+
+    std::printf("occlusion: %d of %d boxes on screen but hidden by ray "
+                "casts, %d culled\n",
+                hidden, BOX_COUNT, occluded);
+    CHECK(falseOcclusions == 0);
+    CHECK(culler.GetStats().testedBoxes == BOX_COUNT);
+    CHECK(culler.GetStats().occludedBoxes == occluded);
+    // The culler is conservative, but should still catch most of them
+    CHECK(occluded * 2 > hidden);
+}
+
+static void testEmptyBuffer() {
+    // Nothing rasterized, nothing can be occluded
+    OcclusionSettings settings;
+    OcclusionCuller culler(settings);
+    culler.SetOccluders(std::vector<Vector3>());
+    Camera3D camera = {0};
+    camera.position = Vector3{0, 0, 0};
+    camera.target = Vector3{0, 0, 1};
+    camera.up = Vector3{0, 1, 0};
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    culler.Render(GetCameraViewProjection(camera, 1.0f));
+    CHECK(culler.IsVisible(BoundingBox{Vector3{-1, -1, 9},
+                                       Vector3{1, 1, 11}}));
+    // Crossing the near plane is always visible
+    CHECK(culler.IsVisible(BoundingBox{Vector3{-1, -1, -1},
+                                       Vector3{1, 1, 1}}));
+}
+
+int main() {
+    testAgainstRayCasts();
+    testEmptyBuffer();
+    return test::Finish("occlusion");
+}
@@ -0,0 +1,62 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+// Minimal test harness: each test executable runs its checks from main()
+// and returns Finish(), which is non-zero when any check failed.
+namespace arena {
+namespace test {
+
+inline int& Failures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int Finish(const char* name) {
+    if (Failures() == 0) {
+        std::printf("%s: passed\n", name);
+        return 0;
+    }
+    std::printf("%s: %d check(s) failed\n", name, Failures());
+    return 1;
+}
+
+// Deterministic random numbers, so failures reproduce
+class Random {
+   public:
+    explicit Random(const uint32_t seed) : m_state(seed) {}
+    float Range(const float min, const float max) {
+        m_state = m_state * 1664525u + 1013904223u;
+        return min + (max - min) * ((m_state >> 8) / 16777216.0f);
+    }
+
+   private:
+    uint32_t m_state;
+};
+
+}  // namespace test
+}  // namespace arena
+
+#define CHECK(condition)                                              \
+    do {                                                              \
+        if (!(condition)) {                                           \
+            std::printf("%s:%d: check failed: %s\n", __FILE__,        \
+                        __LINE__, #condition);                        \
+            arena::test::Failures()++;                                \
+        }                                                             \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                   \
+    do {                                                              \
+        const double checkA = (a), checkB = (b);                      \
+        if (std::fabs(checkA - checkB) > (tolerance)) {               \
+            std::printf("%s:%d: check failed: %s == %s (%g != %g)\n", \
+                        __FILE__, __LINE__, #a, #b, checkA, checkB);  \
+            arena::test::Failures()++;                                \
+        }                                                             \
+    } while (0)
+
+#endif  // TEST_H